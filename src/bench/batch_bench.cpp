@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "heap_bench.h"
+#include "heap_batch.h"
+#include "heap_helper.h"
+
+/*
+ * Time until a whole pool of count buffers is ready, allocated one after
+ * the other. Closing the pool is not timed.
+ */
+static void BM_BatchSequential(benchmark::State &state, struct Heap heap)
+{
+	size_t count = state.range(0);
+	size_t size = state.range(1);
+	std::vector<int> fds(count, -1);
+
+	for (auto _ : state) {
+		int ret = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count && !ret; i++)
+			ret = heap_alloc(heap.fd, size, 0, &fds[i]);
+		auto end = std::chrono::steady_clock::now();
+
+		state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+		for (int &fd : fds) {
+			if (fd >= 0)
+				close(fd);
+			fd = -1;
+		}
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+	}
+
+	state.SetBytesProcessed(state.iterations() * count * size);
+	state.counters["buffers"] = benchmark::Counter(state.iterations() * count,
+						       benchmark::Counter::kIsRate);
+}
+
+/* The same pool from a HeapBatch, the thread pool is set up beforehand */
+static void BM_BatchParallel(benchmark::State &state, struct Heap heap)
+{
+	size_t count = state.range(0);
+	size_t size = state.range(1);
+	HeapBatch batch(state.range(2));
+	std::vector<struct HeapBatch::Request> requests(count, HeapBatch::Request{ heap.fd, size, 0 });
+	std::vector<struct HeapBatch::Result> results;
+
+	for (auto _ : state) {
+		auto start = std::chrono::steady_clock::now();
+		int ret = batch.allocate(requests, HeapBatch::BATCH_ALL_OR_NOTHING, &results);
+		auto end = std::chrono::steady_clock::now();
+
+		state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+		HeapBatch::release(&results);
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+	}
+
+	state.SetBytesProcessed(state.iterations() * count * size);
+	state.counters["buffers"] = benchmark::Counter(state.iterations() * count,
+						       benchmark::Counter::kIsRate);
+}
+
+void register_batch_benchmarks(const std::vector<struct Heap> &heaps)
+{
+	/* a swapchain, a decoder's frame pool and a camera ring */
+	static const int64_t counts[] = { 4, 16, 64 };
+	static const int64_t sizes[] = { 1024 * 1024, 8 * 1024 * 1024 };
+	static const int64_t threads[] = { 2, 4, 8 };
+
+	for (const struct Heap &heap : heaps) {
+		auto sequential = benchmark::RegisterBenchmark(("Batch/Sequential/" + heap.name).c_str(),
+							       BM_BatchSequential, heap);
+		sequential->ArgNames({ "count", "size" });
+		for (int64_t count : counts)
+			for (int64_t size : sizes)
+				sequential->Args({ count, size });
+		sequential->UseManualTime();
+
+		auto parallel = benchmark::RegisterBenchmark(("Batch/Parallel/" + heap.name).c_str(),
+							     BM_BatchParallel, heap);
+		parallel->ArgNames({ "count", "size", "threads" });
+		for (int64_t count : counts)
+			for (int64_t size : sizes)
+				for (int64_t thread : threads)
+					parallel->Args({ count, size, thread });
+		parallel->UseManualTime();
+	}
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "heap_bench.h"
+
+#define HEAP_DIR "/dev/dma_heap"
+
+static std::vector<struct Heap> open_heaps()
+{
+	std::vector<struct Heap> heaps;
+	struct dirent *entry = nullptr;
+	DIR *dp = nullptr;
+
+	dp = opendir(HEAP_DIR);
+	if (dp == nullptr)
+		return heaps;
+
+	while ((entry = readdir(dp))) {
+		if (!strcmp(entry->d_name, "."))
+			continue;
+		if (!strcmp(entry->d_name, ".."))
+			continue;
+
+		struct Heap heap;
+		heap.name = entry->d_name;
+		heap.dev_name = (std::string)HEAP_DIR + "/" + entry->d_name;
+		heap.fd = open(heap.dev_name.c_str(), O_RDONLY | O_CLOEXEC);
+		if (heap.fd < 0)
+			continue;
+		heaps.push_back(heap);
+	}
+	closedir(dp);
+
+	return heaps;
+}
+
+int main(int argc, char *argv[])
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+
+	std::vector<struct Heap> heaps = open_heaps();
+	if (heaps.empty())
+		fprintf(stderr, "No DMA-Heaps found in %s\n", HEAP_DIR);
+
+	register_stream_benchmarks(heaps);
+	register_kernel_benchmarks(heaps);
+	register_numa_benchmarks(heaps);
+	register_pressure_benchmarks(heaps);
+	register_batch_benchmarks(heaps);
+#ifdef HAVE_DRM_H
+	register_prime_benchmarks(heaps);
+#endif
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	for (struct Heap heap : heaps)
+		close(heap.fd);
+
+	return 0;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HEAP_BENCH_H_
+#define HEAP_BENCH_H_
+
+#include <string>
+#include <vector>
+
+struct Heap {
+	std::string name;
+	std::string dev_name;
+	int fd;
+};
+
+/*
+ * Heaps are only known at runtime, so each benchmark file registers its
+ * benchmarks once per discovered heap from one of these.
+ */
+void register_stream_benchmarks(const std::vector<struct Heap> &heaps);
+void register_kernel_benchmarks(const std::vector<struct Heap> &heaps);
+void register_numa_benchmarks(const std::vector<struct Heap> &heaps);
+void register_pressure_benchmarks(const std::vector<struct Heap> &heaps);
+void register_batch_benchmarks(const std::vector<struct Heap> &heaps);
+#ifdef HAVE_DRM_H
+void register_prime_benchmarks(const std::vector<struct Heap> &heaps);
+#endif
+
+#endif /* HEAP_BENCH_H_ */
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <sys/mman.h>
+
+#include <linux/dma-buf.h>
+
+#include <benchmark/benchmark.h>
+
+#include "heap_bench.h"
+#include "heap_helper.h"
+#include "heap_kernels.h"
+
+static const size_t kernelBufferSize = 16 * 1024 * 1024;
+
+enum KernelOp { KERNEL_FILL, KERNEL_COPY, KERNEL_READ };
+
+static void dmabuf_sync(int fd, uint64_t flags)
+{
+	struct dma_buf_sync sync = { flags };
+
+	ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+}
+
+static void BM_Kernel(benchmark::State &state, struct Heap heap,
+		      const struct heap_kernels *kernels, enum KernelOp op)
+{
+	int buf_fd = -1;
+	int ret = heap_alloc(heap.fd, kernelBufferSize, 0, &buf_fd);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		return;
+	}
+
+	void *ptr = mmap(NULL, kernelBufferSize, PROT_READ | PROT_WRITE, MAP_SHARED, buf_fd, 0);
+	if (ptr == MAP_FAILED) {
+		state.SkipWithError(strerror(errno));
+		close(buf_fd);
+		return;
+	}
+
+	auto cached = std::make_unique<uint8_t[]>(kernelBufferSize);
+	memset(cached.get(), 0x5a, kernelBufferSize);
+	memset(ptr, 0, kernelBufferSize);
+
+	for (auto _ : state) {
+		switch (op) {
+		case KERNEL_FILL:
+			kernels->fill(ptr, 0x5a, kernelBufferSize);
+			break;
+		case KERNEL_COPY:
+			kernels->copy(ptr, cached.get(), kernelBufferSize);
+			break;
+		case KERNEL_READ:
+			kernels->read(cached.get(), ptr, kernelBufferSize);
+			break;
+		}
+		benchmark::ClobberMemory();
+	}
+
+	dmabuf_sync(buf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+	bool uncached = heap_kernels_probe(ptr, kernelBufferSize) == HEAP_MAPPING_UNCACHED;
+	bool selected = heap_kernels_select(ptr, kernelBufferSize) == kernels;
+	dmabuf_sync(buf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+	state.SetLabel(std::string(uncached ? "uncached" : "cached") + (selected ? " (selected)" : ""));
+	state.SetBytesProcessed(state.iterations() * kernelBufferSize);
+
+	munmap(ptr, kernelBufferSize);
+	close(buf_fd);
+}
+
+/*
+ * Cost and answer of the cached mapping probe. Ordinary anonymous memory
+ * (heap fd -1) is the reference that must always come out as cached, the
+ * share of probes that did is reported as cached_pct.
+ */
+static void BM_KernelProbe(benchmark::State &state, struct Heap heap)
+{
+	int buf_fd = -1;
+	void *ptr;
+
+	if (heap.fd >= 0) {
+		int ret = heap_alloc(heap.fd, kernelBufferSize, 0, &buf_fd);
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			return;
+		}
+		ptr = mmap(NULL, kernelBufferSize, PROT_READ | PROT_WRITE, MAP_SHARED, buf_fd, 0);
+	} else {
+		ptr = mmap(NULL, kernelBufferSize, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	}
+	if (ptr == MAP_FAILED) {
+		state.SkipWithError(strerror(errno));
+		if (buf_fd >= 0)
+			close(buf_fd);
+		return;
+	}
+	memset(ptr, 0, kernelBufferSize);
+
+	unsigned long cached = 0;
+	for (auto _ : state) {
+		if (buf_fd >= 0)
+			dmabuf_sync(buf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+		auto start = std::chrono::steady_clock::now();
+		if (heap_kernels_probe(ptr, kernelBufferSize) == HEAP_MAPPING_CACHED)
+			cached++;
+		auto end = std::chrono::steady_clock::now();
+		if (buf_fd >= 0)
+			dmabuf_sync(buf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+
+		state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+	}
+
+	if (state.iterations())
+		state.counters["cached_pct"] = cached * 100.0 / state.iterations();
+	if (heap.fd < 0 && (benchmark::IterationCount)cached != state.iterations())
+		state.SetLabel("cached memory probed as uncached");
+
+	munmap(ptr, kernelBufferSize);
+	if (buf_fd >= 0)
+		close(buf_fd);
+}
+
+void register_kernel_benchmarks(const std::vector<struct Heap> &heaps)
+{
+	static const struct {
+		const char *name;
+		enum KernelOp op;
+	} ops[] = {
+		{ "Fill", KERNEL_FILL },
+		{ "Copy", KERNEL_COPY },
+		{ "Read", KERNEL_READ },
+	};
+
+	struct Heap anon = { "anon", "", -1 };
+	benchmark::RegisterBenchmark("Kernels/Probe/anon", BM_KernelProbe, anon)->UseManualTime();
+	for (const struct Heap &heap : heaps)
+		benchmark::RegisterBenchmark(("Kernels/Probe/" + heap.name).c_str(),
+					     BM_KernelProbe, heap)->UseManualTime();
+
+	for (const struct Heap &heap : heaps) {
+		for (auto op : ops) {
+			const struct heap_kernels *kernels;
+			for (unsigned int k = 0; (kernels = heap_kernels_get(k)); k++) {
+				std::string name = std::string("Kernels/") + op.name + "/" +
+						   heap.name + "/" + kernels->name;
+				benchmark::RegisterBenchmark(name.c_str(), BM_Kernel, heap, kernels, op.op);
+			}
+		}
+	}
+}
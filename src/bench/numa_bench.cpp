@@ -0,0 +1,418 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <map>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "heap_bench.h"
+#include "heap_helper.h"
+
+#define NODE_DIR "/sys/devices/system/node"
+#define MEMORY_DIR "/sys/devices/system/memory"
+
+static const size_t numaBufferSize = 64 * 1024 * 1024;
+
+struct Node {
+	int id;
+	std::vector<int> cpus;
+};
+
+static std::vector<int> parse_cpulist(const char *list)
+{
+	std::vector<int> cpus;
+	const char *p = list;
+
+	while (*p && *p != '\n') {
+		char *end;
+		int first = strtol(p, &end, 10);
+		int last = first;
+		if (end == p)
+			break;
+		p = end;
+		if (*p == '-') {
+			last = strtol(p + 1, &end, 10);
+			p = end;
+		}
+		for (int cpu = first; cpu <= last; cpu++)
+			cpus.push_back(cpu);
+		if (*p == ',')
+			p++;
+	}
+
+	return cpus;
+}
+
+/*
+ * Nodes with at least one CPU we are allowed to run on. Without NUMA
+ * support in the kernel everything is reported as a single node 0.
+ */
+static std::vector<struct Node> numa_nodes()
+{
+	std::vector<struct Node> nodes;
+	cpu_set_t allowed;
+
+	CPU_ZERO(&allowed);
+	sched_getaffinity(0, sizeof(allowed), &allowed);
+
+	DIR *dp = opendir(NODE_DIR);
+	struct dirent *entry;
+	while (dp && (entry = readdir(dp))) {
+		int id;
+		if (sscanf(entry->d_name, "node%d", &id) != 1)
+			continue;
+
+		std::string path = std::string(NODE_DIR "/") + entry->d_name + "/cpulist";
+		FILE *f = fopen(path.c_str(), "r");
+		if (!f)
+			continue;
+		char buf[4096] = { 0 };
+		if (!fgets(buf, sizeof(buf), f))
+			buf[0] = '\0';
+		fclose(f);
+
+		struct Node node = { id, {} };
+		for (int cpu : parse_cpulist(buf))
+			if (CPU_ISSET(cpu, &allowed))
+				node.cpus.push_back(cpu);
+		if (!node.cpus.empty())
+			nodes.push_back(node);
+	}
+	if (dp)
+		closedir(dp);
+
+	if (nodes.empty()) {
+		struct Node node = { 0, {} };
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+			if (CPU_ISSET(cpu, &allowed))
+				node.cpus.push_back(cpu);
+		nodes.push_back(node);
+	}
+
+	std::sort(nodes.begin(), nodes.end(),
+		  [](const struct Node &a, const struct Node &b) { return a.id < b.id; });
+
+	return nodes;
+}
+
+static const struct Node *find_node(int id)
+{
+	static const std::vector<struct Node> nodes = numa_nodes();
+
+	for (const struct Node &node : nodes)
+		if (node.id == id)
+			return &node;
+
+	return nullptr;
+}
+
+/* Pin the calling thread to one CPU, returns 0 or a negative errno */
+static int pin_to_cpu(int cpu)
+{
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set))
+		return -errno;
+
+	return 0;
+}
+
+/*
+ * Which node backs the page at addr. move_pages() only knows about
+ * ordinary LRU pages, dma-buf mappings are usually PFN maps so fall back
+ * to the PFN from pagemap (needs CAP_SYS_ADMIN) and the node owning its
+ * memory block. Returns -1 when neither works.
+ */
+static int page_node(void *addr)
+{
+	void *pages[1] = { addr };
+	int status[1] = { -1 };
+
+	if (!syscall(SYS_move_pages, 0, 1, pages, NULL, status, 0) && status[0] >= 0)
+		return status[0];
+
+	static std::map<unsigned long, int> block_nodes;
+	static unsigned long block_size;
+	if (!block_size) {
+		FILE *f = fopen(MEMORY_DIR "/block_size_bytes", "r");
+		if (!f || fscanf(f, "%lx", &block_size) != 1)
+			block_size = 0;
+		if (f)
+			fclose(f);
+
+		DIR *dp = opendir(NODE_DIR);
+		struct dirent *entry;
+		while (block_size && dp && (entry = readdir(dp))) {
+			int id;
+			if (sscanf(entry->d_name, "node%d", &id) != 1)
+				continue;
+			std::string path = std::string(NODE_DIR "/") + entry->d_name;
+			DIR *node_dp = opendir(path.c_str());
+			struct dirent *block;
+			while (node_dp && (block = readdir(node_dp))) {
+				unsigned long nr;
+				if (sscanf(block->d_name, "memory%lu", &nr) == 1)
+					block_nodes[nr] = id;
+			}
+			if (node_dp)
+				closedir(node_dp);
+		}
+		if (dp)
+			closedir(dp);
+	}
+	if (!block_size)
+		return -1;
+
+	int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	unsigned long psize = sysconf(_SC_PAGESIZE);
+	uint64_t entry = 0;
+	ssize_t ret = pread(fd, &entry, sizeof(entry), (uintptr_t)addr / psize * sizeof(entry));
+	close(fd);
+
+	uint64_t pfn = entry & ((1ULL << 55) - 1);
+	if (ret != sizeof(entry) || !(entry & (1ULL << 63)) || !pfn)
+		return -1;
+
+	auto it = block_nodes.find(pfn * psize / block_size);
+
+	return it == block_nodes.end() ? -1 : it->second;
+}
+
+/* Allocate from a thread pinned to the first CPU of the given node */
+static int alloc_on_node(int heap_fd, size_t size, const struct Node *node, int *buf_fd)
+{
+	int ret = 0;
+
+	std::thread allocator([&] {
+		ret = pin_to_cpu(node->cpus[0]);
+		if (!ret)
+			ret = heap_alloc(heap_fd, size, 0, buf_fd);
+	});
+	allocator.join();
+
+	return ret;
+}
+
+static uint64_t touch_pages(volatile uint8_t *ptr, size_t size)
+{
+	unsigned long psize = sysconf(_SC_PAGESIZE);
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < size; i += psize)
+		sum += ptr[i];
+
+	return sum;
+}
+
+static uint64_t sum_words(const uint8_t *ptr, size_t len)
+{
+	const uint64_t *words = (const uint64_t *)ptr;
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < len / sizeof(uint64_t); i++)
+		sum += words[i];
+
+	return sum;
+}
+
+static void report_node(benchmark::State &state, void *ptr, int access_node)
+{
+	int node = page_node(ptr);
+
+	state.counters["page_node"] = node;
+	if (node < 0)
+		state.SetLabel("page node unknown");
+	else
+		state.SetLabel(node == access_node ? "local" : "remote");
+}
+
+/*
+ * Time from mmap() through touching every page of a buffer allocated on
+ * one node while faulting it in from another.
+ */
+static void BM_Fault(benchmark::State &state, struct Heap heap)
+{
+	const struct Node *alloc_node = find_node(state.range(0));
+	const struct Node *fault_node = find_node(state.range(1));
+	unsigned long psize = sysconf(_SC_PAGESIZE);
+	cpu_set_t saved;
+
+	int buf_fd = -1;
+	int ret = alloc_on_node(heap.fd, numaBufferSize, alloc_node, &buf_fd);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		return;
+	}
+
+	sched_getaffinity(0, sizeof(saved), &saved);
+	ret = pin_to_cpu(fault_node->cpus[0]);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		close(buf_fd);
+		return;
+	}
+
+	uint64_t fault_ns = 0;
+	bool reported = false;
+	for (auto _ : state) {
+		auto start = std::chrono::steady_clock::now();
+		void *ptr = mmap(NULL, numaBufferSize, PROT_READ, MAP_SHARED, buf_fd, 0);
+		if (ptr == MAP_FAILED) {
+			state.SkipWithError(strerror(errno));
+			break;
+		}
+		benchmark::DoNotOptimize(touch_pages((volatile uint8_t *)ptr, numaBufferSize));
+		auto end = std::chrono::steady_clock::now();
+		fault_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+		if (!reported)
+			report_node(state, ptr, fault_node->id);
+		reported = true;
+		munmap(ptr, numaBufferSize);
+	}
+
+	if (state.iterations())
+		state.counters["fault_ns"] = (double)fault_ns / state.iterations() /
+					     (numaBufferSize / psize);
+
+	sched_setaffinity(0, sizeof(saved), &saved);
+	close(buf_fd);
+}
+
+/*
+ * Read bandwidth of a buffer allocated on one node, faulted in from a
+ * second and read by threads spread over the CPUs of a third.
+ */
+static void BM_Bandwidth(benchmark::State &state, struct Heap heap)
+{
+	const struct Node *alloc_node = find_node(state.range(0));
+	const struct Node *fault_node = find_node(state.range(1));
+	const struct Node *access_node = find_node(state.range(2));
+	unsigned int nthreads = state.range(3);
+
+	int buf_fd = -1;
+	int ret = alloc_on_node(heap.fd, numaBufferSize, alloc_node, &buf_fd);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		return;
+	}
+
+	void *ptr = MAP_FAILED;
+	std::thread faulter([&] {
+		if (pin_to_cpu(fault_node->cpus[0]))
+			return;
+		ptr = mmap(NULL, numaBufferSize, PROT_READ, MAP_SHARED, buf_fd, 0);
+		if (ptr != MAP_FAILED)
+			touch_pages((volatile uint8_t *)ptr, numaBufferSize);
+	});
+	faulter.join();
+	if (ptr == MAP_FAILED) {
+		state.SkipWithError("could not map buffer from fault node");
+		close(buf_fd);
+		return;
+	}
+	report_node(state, ptr, access_node->id);
+
+	pthread_barrier_t start, done;
+	pthread_barrier_init(&start, NULL, nthreads + 1);
+	pthread_barrier_init(&done, NULL, nthreads + 1);
+	bool stop = false;
+
+	std::vector<std::thread> readers;
+	size_t slice = numaBufferSize / nthreads;
+	for (unsigned int i = 0; i < nthreads; i++) {
+		readers.emplace_back([&, i] {
+			pin_to_cpu(access_node->cpus[i % access_node->cpus.size()]);
+			for (;;) {
+				pthread_barrier_wait(&start);
+				if (stop)
+					break;
+				benchmark::DoNotOptimize(sum_words((const uint8_t *)ptr + i * slice, slice));
+				pthread_barrier_wait(&done);
+			}
+		});
+	}
+
+	for (auto _ : state) {
+		pthread_barrier_wait(&start);
+		auto begin = std::chrono::steady_clock::now();
+		pthread_barrier_wait(&done);
+		auto end = std::chrono::steady_clock::now();
+		state.SetIterationTime(std::chrono::duration<double>(end - begin).count());
+	}
+
+	stop = true;
+	pthread_barrier_wait(&start);
+	for (std::thread &reader : readers)
+		reader.join();
+	pthread_barrier_destroy(&start);
+	pthread_barrier_destroy(&done);
+
+	state.SetBytesProcessed(state.iterations() * slice * nthreads);
+	munmap(ptr, numaBufferSize);
+	close(buf_fd);
+}
+
+void register_numa_benchmarks(const std::vector<struct Heap> &heaps)
+{
+	std::vector<struct Node> nodes = numa_nodes();
+
+	fprintf(stderr, "NUMA nodes:");
+	for (const struct Node &node : nodes)
+		fprintf(stderr, " %d (%zu CPUs)", node.id, node.cpus.size());
+	fprintf(stderr, "\n");
+
+	for (const struct Heap &heap : heaps) {
+		auto fault = benchmark::RegisterBenchmark(("NUMA/Fault/" + heap.name).c_str(),
+							  BM_Fault, heap);
+		fault->ArgNames({ "alloc", "fault" });
+		for (const struct Node &a : nodes)
+			for (const struct Node &f : nodes)
+				fault->Args({ a.id, f.id });
+
+		auto bandwidth = benchmark::RegisterBenchmark(("NUMA/Bandwidth/" + heap.name).c_str(),
+							      BM_Bandwidth, heap);
+		bandwidth->ArgNames({ "alloc", "fault", "access", "threads" })->UseManualTime();
+		for (const struct Node &a : nodes) {
+			for (const struct Node &x : nodes) {
+				std::vector<int64_t> threads = { 1 };
+				if (x.cpus.size() > 1)
+					threads.push_back(x.cpus.size());
+				for (int64_t t : threads) {
+					bandwidth->Args({ a.id, a.id, x.id, t });
+					if (x.id != a.id)
+						bandwidth->Args({ a.id, x.id, x.id, t });
+				}
+			}
+		}
+	}
+}
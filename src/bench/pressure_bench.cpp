@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "heap_bench.h"
+#include "heap_helper.h"
+
+#define CGROUP_DIR "/sys/fs/cgroup"
+
+/* Dirty page cache is throttled to disk speed, do not write more than this */
+static const size_t maxDirtyBytes = 2UL * 1024 * 1024 * 1024;
+/* Share of the pressure a memory cgroup lets stay resident, the rest is reclaimed */
+static const size_t cgroupLimitPct = 50;
+/* Free blocks of at least this order count as high-order, 2M with 4K pages */
+static const int highOrder = 9;
+/* Above this share of MemAvailable the pressure must be confined to a memory cgroup */
+static const int64_t maxUnconfinedLevel = 50;
+
+enum PressureKind {
+	PRESSURE_NONE,
+	PRESSURE_MEMFD,
+	PRESSURE_ANON,
+	PRESSURE_DIRTY,
+};
+
+static const char *pressureNames[] = { "none", "memfd", "anon", "dirty" };
+
+struct Pressure {
+	int fd;
+	void *map;
+	size_t size;
+	bool tmpfs;
+};
+
+static size_t meminfo(const char *field)
+{
+	FILE *f = fopen("/proc/meminfo", "r");
+	std::string format = std::string(field) + ": %zu kB";
+	char line[256];
+	size_t kb = 0;
+
+	while (f && fgets(line, sizeof(line), f))
+		if (sscanf(line, format.c_str(), &kb) == 1)
+			break;
+	if (f)
+		fclose(f);
+
+	return kb * 1024;
+}
+
+static const char *pressure_dir()
+{
+	return getenv("TMPDIR") ? getenv("TMPDIR") : "/var/tmp";
+}
+
+/* Share of free memory in blocks of highOrder and above, -1 if unknown */
+static double free_high_order_pct()
+{
+	FILE *f = fopen("/proc/buddyinfo", "r");
+	char line[512];
+	double total = 0, high = 0;
+
+	while (f && fgets(line, sizeof(line), f)) {
+		char *p = strstr(line, "zone");
+		if (!p)
+			continue;
+		p += 4;
+		while (*p == ' ')
+			p++;
+		while (*p && *p != ' ')
+			p++;
+
+		char *end;
+		for (int order = 0;; order++, p = end) {
+			unsigned long count = strtoul(p, &end, 10);
+			if (end == p)
+				break;
+			total += (double)(count << order);
+			if (order >= highOrder)
+				high += (double)(count << order);
+		}
+	}
+	if (f)
+		fclose(f);
+
+	return total ? high * 100 / total : -1;
+}
+
+/* Fill size bytes of memory of the given kind, returns 0 or a negative errno */
+static int pressure_apply(enum PressureKind kind, size_t size, struct Pressure *pressure)
+{
+	*pressure = { -1, MAP_FAILED, 0, false };
+
+	switch (kind) {
+	case PRESSURE_NONE:
+		return 0;
+	case PRESSURE_MEMFD:
+		/* shmem pages, only reclaimable to swap */
+		pressure->fd = memfd_create("pressure", MFD_CLOEXEC);
+		if (pressure->fd < 0)
+			return -errno;
+		if (fallocate(pressure->fd, 0, 0, size))
+			return -errno;
+		break;
+	case PRESSURE_ANON:
+		pressure->map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				     MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+		if (pressure->map == MAP_FAILED)
+			return -errno;
+		break;
+	case PRESSURE_DIRTY: {
+		/* page cache that must be written back before it can be reclaimed */
+		const char *dir = pressure_dir();
+		struct statfs fs;
+		pressure->fd = open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+		if (pressure->fd < 0 && errno == EOPNOTSUPP) {
+			std::string name = std::string(dir) + "/dma-heap-pressure.XXXXXX";
+			pressure->fd = mkostemp(&name[0], O_CLOEXEC);
+			if (pressure->fd >= 0)
+				unlink(name.c_str());
+		}
+		if (pressure->fd < 0)
+			return -errno;
+		if (!fstatfs(pressure->fd, &fs))
+			pressure->tmpfs = fs.f_type == TMPFS_MAGIC;
+
+		static const size_t chunk = 1024 * 1024;
+		auto buf = std::make_unique<uint8_t[]>(chunk);
+		memset(buf.get(), 0x5a, chunk);
+		for (size_t done = 0; done < size;) {
+			ssize_t ret = write(pressure->fd, buf.get(), std::min(chunk, size - done));
+			if (ret < 0 && errno == EINTR)
+				continue;
+			if (ret < 0)
+				return -errno;
+			if (!ret)
+				return -ENOSPC;
+			done += ret;
+		}
+		break;
+	}
+	}
+	pressure->size = size;
+
+	return 0;
+}
+
+static void pressure_release(struct Pressure *pressure)
+{
+	if (pressure->map != MAP_FAILED)
+		munmap(pressure->map, pressure->size);
+	if (pressure->fd >= 0)
+		close(pressure->fd);
+	pressure->fd = -1;
+	pressure->map = MAP_FAILED;
+}
+
+static bool write_file(const std::string &path, const std::string &value)
+{
+	int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+	bool ok = write(fd, value.c_str(), value.size()) == (ssize_t)value.size();
+	close(fd);
+
+	return ok;
+}
+
+static unsigned long read_event(const std::string &path, const char *event)
+{
+	FILE *f = fopen(path.c_str(), "r");
+	char name[64];
+	unsigned long value, found = 0;
+
+	while (f && fscanf(f, "%63s %lu", name, &value) == 2)
+		if (!strcmp(name, event))
+			found = value;
+	if (f)
+		fclose(f);
+
+	return found;
+}
+
+struct MemCgroup {
+	std::string path;
+	std::string home;
+	bool v1;
+};
+
+static bool has_controller(const std::string &path, const char *controller)
+{
+	FILE *f = fopen(path.c_str(), "r");
+	char name[64];
+	bool found = false;
+
+	while (f && fscanf(f, "%63s", name) == 1)
+		if (!strcmp(name, controller))
+			found = true;
+	if (f)
+		fclose(f);
+
+	return found;
+}
+
+/* The process' cgroup in the hierarchy of the given controllers, "" for v2 */
+static std::string own_cgroup(const char *controllers)
+{
+	FILE *f = fopen("/proc/self/cgroup", "r");
+	char line[4096];
+	std::string own;
+
+	while (f && fgets(line, sizeof(line), f)) {
+		char *name = strchr(line, ':');
+		char *path = name ? strchr(name + 1, ':') : NULL;
+		if (!path || strncmp(name + 1, controllers, path - name - 1) ||
+		    strlen(controllers) != (size_t)(path - name - 1))
+			continue;
+		own = std::string(path + 1, strcspn(path + 1, "\n"));
+	}
+	if (f)
+		fclose(f);
+
+	return own;
+}
+
+/*
+ * Move the process into a new memory cgroup limited to limit bytes. On
+ * cgroup v2 it goes next to the one the process runs in, which needs the
+ * memory controller already handed down by the parent; with the v1 memory
+ * hierarchy of a hybrid setup it goes below it. Returns 0 or a negative
+ * errno, -ENOTSUP when no memory controller is available to us.
+ */
+static int memcg_enter(size_t limit, struct MemCgroup *cg)
+{
+	struct statfs fs;
+	std::string own;
+
+	if (!statfs(CGROUP_DIR, &fs) && fs.f_type == CGROUP2_SUPER_MAGIC) {
+		own = own_cgroup("");
+		if (own.empty())
+			return -ENOENT;
+		std::string parent = own.substr(0, own.rfind('/'));
+		if (!has_controller(CGROUP_DIR + parent + "/cgroup.subtree_control", "memory"))
+			return -ENOTSUP;
+		cg->v1 = false;
+		cg->home = CGROUP_DIR + own;
+		cg->path = CGROUP_DIR + parent + "/dma-heap-bench." + std::to_string(getpid());
+	} else if (!statfs(CGROUP_DIR "/memory", &fs) && fs.f_type == CGROUP_SUPER_MAGIC) {
+		own = own_cgroup("memory");
+		if (own.empty())
+			return -ENOENT;
+		if (own == "/")
+			own.clear();
+		cg->v1 = true;
+		cg->home = CGROUP_DIR "/memory" + own;
+		cg->path = cg->home + "/dma-heap-bench." + std::to_string(getpid());
+	} else {
+		return -ENOTSUP;
+	}
+
+	if (mkdir(cg->path.c_str(), 0755))
+		return -errno;
+	errno = 0;
+	if (!write_file(cg->path + (cg->v1 ? "/memory.limit_in_bytes" : "/memory.max"),
+			std::to_string(limit)) ||
+	    !write_file(cg->path + "/cgroup.procs", std::to_string(getpid()))) {
+		int ret = errno ? -errno : -EIO;
+		rmdir(cg->path.c_str());
+		return ret;
+	}
+
+	return 0;
+}
+
+/* How often the cgroup ran into its limit so far */
+static unsigned long memcg_limit_hits(const struct MemCgroup *cg)
+{
+	if (!cg->v1)
+		return read_event(cg->path + "/memory.events", "max");
+
+	FILE *f = fopen((cg->path + "/memory.failcnt").c_str(), "r");
+	unsigned long value = 0;
+	if (f) {
+		if (fscanf(f, "%lu", &value) != 1)
+			value = 0;
+		fclose(f);
+	}
+
+	return value;
+}
+
+static void memcg_leave(struct MemCgroup *cg)
+{
+	write_file(cg->home + "/cgroup.procs", std::to_string(getpid()));
+	rmdir(cg->path.c_str());
+}
+
+/*
+ * Allocation latency and failure rate with part of the available memory
+ * taken up by the chosen kind of pressure, optionally confined to a memory
+ * cgroup that lets only cgroupLimitPct of it stay resident, so the rest is
+ * reclaimed inside the cgroup while the heap allocates. Only the pressure
+ * is limited that way: DMA-Heap buffers are not charged to the memory
+ * cgroup, so the heap allocations themselves are never held to its limit,
+ * the memcg rows show the effect of the reclaim it causes. Pressure that
+ * can only be reclaimed to swap needs enough free swap for the part above
+ * the limit, the cgroup's OOM killer would end the run otherwise. Failures
+ * are timed like successes, they are often the slow ones.
+ */
+static void BM_Pressure(benchmark::State &state, struct Heap heap)
+{
+	enum PressureKind kind = (enum PressureKind)state.range(0);
+	size_t pressure_size = meminfo("MemAvailable") / 100 * state.range(1);
+	size_t size = state.range(2);
+	bool memcg = state.range(3);
+	struct MemCgroup cg;
+	struct Pressure pressure;
+	int ret;
+
+	/* this much unconfined pressure invites the OOM killer */
+	if (kind != PRESSURE_NONE && state.range(1) > maxUnconfinedLevel && !memcg) {
+		state.SkipWithError("pressure level needs a memory cgroup");
+		return;
+	}
+	if (kind == PRESSURE_DIRTY)
+		pressure_size = std::min(pressure_size, maxDirtyBytes);
+
+	if (memcg) {
+		size_t limit = pressure_size / 100 * cgroupLimitPct;
+		struct statfs fs;
+		bool swap_only = kind != PRESSURE_DIRTY ||
+				 (!statfs(pressure_dir(), &fs) && fs.f_type == TMPFS_MAGIC);
+		if (swap_only && meminfo("SwapFree") < pressure_size - limit) {
+			state.SkipWithError("not enough free swap to reclaim the confined pressure");
+			return;
+		}
+		ret = memcg_enter(limit, &cg);
+		if (ret) {
+			state.SkipWithError(("no memory cgroup with the memory controller: " +
+					     std::string(strerror(-ret))).c_str());
+			return;
+		}
+	}
+	unsigned long hits = memcg ? memcg_limit_hits(&cg) : 0;
+
+	ret = pressure_apply(kind, pressure_size, &pressure);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		pressure_release(&pressure);
+		if (memcg)
+			memcg_leave(&cg);
+		return;
+	}
+	double high_order = free_high_order_pct();
+
+	std::vector<double> latencies;
+	unsigned long failures = 0;
+	for (auto _ : state) {
+		int buf_fd = -1;
+		auto start = std::chrono::steady_clock::now();
+		ret = heap_alloc(heap.fd, size, 0, &buf_fd);
+		auto end = std::chrono::steady_clock::now();
+		double elapsed = std::chrono::duration<double>(end - start).count();
+
+		state.SetIterationTime(elapsed);
+		latencies.push_back(elapsed);
+		if (ret)
+			failures++;
+		else
+			close(buf_fd);
+	}
+
+	if (!latencies.empty()) {
+		std::sort(latencies.begin(), latencies.end());
+		state.counters["p50_us"] = latencies[latencies.size() / 2] * 1e6;
+		state.counters["p99_us"] = latencies[latencies.size() * 99 / 100] * 1e6;
+		state.counters["max_us"] = latencies.back() * 1e6;
+		state.counters["fail_rate"] = (double)failures / latencies.size();
+	}
+	state.counters["pressure_mb"] = pressure.size >> 20;
+	state.counters["free_high_order_pct"] = high_order;
+	if (memcg)
+		state.counters["memcg_limit_hits"] = memcg_limit_hits(&cg) - hits;
+	state.SetLabel(std::string(pressureNames[kind]) + ", " +
+		       (size >= (4096UL << highOrder) ? "high-order" : "order-0") +
+		       (pressure.tmpfs ? ", dirty file on tmpfs" : ""));
+
+	pressure_release(&pressure);
+	if (memcg)
+		memcg_leave(&cg);
+}
+
+void register_pressure_benchmarks(const std::vector<struct Heap> &heaps)
+{
+	/* an order-0 page against a buffer needing, or at least wanting, high orders */
+	static const int64_t sizes[] = { 4 * 1024, 2 * 1024 * 1024 };
+	/* percent of MemAvailable taken up by the pressure */
+	static const int64_t levels[] = { 50, 90 };
+
+	for (const struct Heap &heap : heaps) {
+		auto bench = benchmark::RegisterBenchmark(("Pressure/" + heap.name).c_str(),
+							  BM_Pressure, heap);
+		bench->ArgNames({ "pressure", "level", "size", "memcg" });
+		for (int64_t size : sizes)
+			bench->Args({ PRESSURE_NONE, 0, size, 0 });
+		for (int kind = PRESSURE_MEMFD; kind <= PRESSURE_DIRTY; kind++)
+			for (int64_t level : levels)
+				for (int64_t size : sizes)
+					for (int memcg = level > maxUnconfinedLevel; memcg <= 1; memcg++)
+						bench->Args({ kind, level, size, memcg });
+		/* pressure is set up once per run, keep it to a single fixed-length run */
+		bench->Iterations(200)->UseManualTime();
+	}
+}
@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <drm/drm.h>
+#include <drm/drm_mode.h>
+
+#include <benchmark/benchmark.h>
+
+#include "heap_bench.h"
+#include "heap_helper.h"
+
+/*
+ * PRIME import/export cost against the software DRM drivers, no GPU
+ * needed. vkms is preferred as it can also create framebuffers, vgem
+ * only covers import and export.
+ */
+
+struct DrmDevice {
+	int fd;
+	std::string name;
+	bool kms;
+};
+
+static struct DrmDevice find_virtual_drm()
+{
+	static const char *drivers[] = { "vkms", "vgem" };
+	struct DrmDevice found = { -1, "", false };
+
+	for (const char *driver : drivers) {
+		for (int i = 0; i < 64; i++) {
+			std::string path = "/dev/dri/card" + std::to_string(i);
+			int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+			if (fd < 0)
+				continue;
+
+			char name[32] = { 0 };
+			struct drm_version version = {};
+			version.name = name;
+			version.name_len = sizeof(name) - 1;
+			if (!ioctl(fd, DRM_IOCTL_VERSION, &version) && !strcmp(name, driver)) {
+				found.fd = fd;
+				found.name = name;
+				found.kms = !strcmp(name, "vkms");
+				return found;
+			}
+			close(fd);
+		}
+	}
+
+	return found;
+}
+
+static const struct DrmDevice &drm_device()
+{
+	static const struct DrmDevice device = find_virtual_drm();
+
+	return device;
+}
+
+static int prime_import(int dri_fd, int dma_buf_fd, uint32_t *handle)
+{
+	struct drm_prime_handle prime_to_handle = {};
+	prime_to_handle.fd = dma_buf_fd;
+	if (ioctl(dri_fd, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime_to_handle))
+		return -errno;
+	*handle = prime_to_handle.handle;
+
+	return 0;
+}
+
+static int prime_export(int dri_fd, uint32_t handle, int *dma_buf_fd)
+{
+	struct drm_prime_handle handle_to_prime = {};
+	handle_to_prime.handle = handle;
+	handle_to_prime.flags = DRM_CLOEXEC | DRM_RDWR;
+	if (ioctl(dri_fd, DRM_IOCTL_PRIME_HANDLE_TO_FD, &handle_to_prime))
+		return -errno;
+	*dma_buf_fd = handle_to_prime.fd;
+
+	return 0;
+}
+
+static int gem_close(int dri_fd, uint32_t handle)
+{
+	struct drm_gem_close close_handle = {};
+	close_handle.handle = handle;
+	if (ioctl(dri_fd, DRM_IOCTL_GEM_CLOSE, &close_handle))
+		return -errno;
+
+	return 0;
+}
+
+static double elapsed(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Allocate the heap buffer and check for a device, false if skipped */
+static bool prime_setup(benchmark::State &state, struct Heap &heap, size_t size, int *buf_fd)
+{
+	if (drm_device().fd < 0) {
+		state.SkipWithError("no vgem or vkms device");
+		return false;
+	}
+
+	int ret = heap_alloc(heap.fd, size, 0, buf_fd);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		return false;
+	}
+	state.SetLabel(drm_device().name);
+
+	return true;
+}
+
+/* Full import of a buffer the device has not seen, the close is not timed */
+static void BM_Import(benchmark::State &state, struct Heap heap)
+{
+	int dri_fd = drm_device().fd;
+	int buf_fd = -1;
+	if (!prime_setup(state, heap, state.range(0), &buf_fd))
+		return;
+
+	double close_s = 0;
+	for (auto _ : state) {
+		uint32_t handle = 0;
+		auto start = std::chrono::steady_clock::now();
+		int ret = prime_import(dri_fd, buf_fd, &handle);
+		state.SetIterationTime(elapsed(start));
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+
+		start = std::chrono::steady_clock::now();
+		gem_close(dri_fd, handle);
+		close_s += elapsed(start);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	if (state.iterations())
+		state.counters["close_us"] = close_s * 1e6 / state.iterations();
+	close(buf_fd);
+}
+
+/* Importing an already imported buffer only looks up the existing handle */
+static void BM_ImportRepeat(benchmark::State &state, struct Heap heap)
+{
+	int dri_fd = drm_device().fd;
+	int buf_fd = -1;
+	if (!prime_setup(state, heap, state.range(0), &buf_fd))
+		return;
+
+	uint32_t first = 0;
+	int ret = prime_import(dri_fd, buf_fd, &first);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		close(buf_fd);
+		return;
+	}
+
+	for (auto _ : state) {
+		uint32_t handle = 0;
+		auto start = std::chrono::steady_clock::now();
+		ret = prime_import(dri_fd, buf_fd, &handle);
+		state.SetIterationTime(elapsed(start));
+		if (ret || handle != first) {
+			state.SkipWithError(ret ? strerror(-ret) : "repeated import gave a new handle");
+			break;
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	gem_close(dri_fd, first);
+	close(buf_fd);
+}
+
+/*
+ * Export of a freshly imported heap buffer, the first HANDLE_TO_FD on its
+ * handle. Import, close and GEM_CLOSE are not timed.
+ */
+static void BM_Export(benchmark::State &state, struct Heap heap)
+{
+	int dri_fd = drm_device().fd;
+	int buf_fd = -1;
+	if (!prime_setup(state, heap, state.range(0), &buf_fd))
+		return;
+
+	for (auto _ : state) {
+		uint32_t handle = 0;
+		int ret = prime_import(dri_fd, buf_fd, &handle);
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+
+		int export_fd = -1;
+		auto start = std::chrono::steady_clock::now();
+		ret = prime_export(dri_fd, handle, &export_fd);
+		state.SetIterationTime(elapsed(start));
+
+		if (!ret)
+			close(export_fd);
+		gem_close(dri_fd, handle);
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	close(buf_fd);
+}
+
+/* Exporting the same handle again only looks up the DMA-BUF cached on it */
+static void BM_ExportRepeat(benchmark::State &state, struct Heap heap)
+{
+	int dri_fd = drm_device().fd;
+	int buf_fd = -1;
+	if (!prime_setup(state, heap, state.range(0), &buf_fd))
+		return;
+
+	uint32_t handle = 0;
+	int ret = prime_import(dri_fd, buf_fd, &handle);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		close(buf_fd);
+		return;
+	}
+
+	for (auto _ : state) {
+		int export_fd = -1;
+		auto start = std::chrono::steady_clock::now();
+		ret = prime_export(dri_fd, handle, &export_fd);
+		state.SetIterationTime(elapsed(start));
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+		close(export_fd);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	gem_close(dri_fd, handle);
+	close(buf_fd);
+}
+
+/*
+ * Export of a buffer the driver allocated itself, for comparison. Every
+ * iteration exports a new dumb buffer, so a DMA-BUF is really created;
+ * creating and destroying the buffer is not timed.
+ */
+static void BM_ExportDumb(benchmark::State &state)
+{
+	int dri_fd = drm_device().fd;
+	if (dri_fd < 0) {
+		state.SkipWithError("no vgem or vkms device");
+		return;
+	}
+	state.SetLabel(drm_device().name);
+
+	for (auto _ : state) {
+		struct drm_mode_create_dumb create_dumb = {};
+		create_dumb.width = 1024;
+		create_dumb.height = state.range(0) / (1024 * 4);
+		create_dumb.bpp = 32;
+		if (ioctl(dri_fd, DRM_IOCTL_MODE_CREATE_DUMB, &create_dumb)) {
+			state.SkipWithError(strerror(errno));
+			break;
+		}
+
+		int export_fd = -1;
+		auto start = std::chrono::steady_clock::now();
+		int ret = prime_export(dri_fd, create_dumb.handle, &export_fd);
+		state.SetIterationTime(elapsed(start));
+
+		if (!ret)
+			close(export_fd);
+		struct drm_mode_destroy_dumb destroy_dumb = {};
+		destroy_dumb.handle = create_dumb.handle;
+		ioctl(dri_fd, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy_dumb);
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+/*
+ * What allocate_attach_fb() pays per buffer: import, create a 32 bpp
+ * framebuffer 1024 pixels wide, then tear both down again (not timed).
+ */
+static void BM_AttachFb(benchmark::State &state, struct Heap heap)
+{
+	int dri_fd = drm_device().fd;
+	int buf_fd = -1;
+	if (!prime_setup(state, heap, state.range(0), &buf_fd))
+		return;
+	if (!drm_device().kms) {
+		state.SkipWithError("device has no KMS");
+		close(buf_fd);
+		return;
+	}
+
+	double import_s = 0;
+	for (auto _ : state) {
+		uint32_t handle = 0;
+		auto start = std::chrono::steady_clock::now();
+		int ret = prime_import(dri_fd, buf_fd, &handle);
+		import_s += elapsed(start);
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+
+		struct drm_mode_fb_cmd fb_cmd = {};
+		fb_cmd.width = 1024;
+		fb_cmd.height = state.range(0) / (1024 * 4);
+		fb_cmd.bpp = 32;
+		fb_cmd.pitch = 1024 * 4;
+		fb_cmd.depth = 24;
+		fb_cmd.handle = handle;
+		ret = ioctl(dri_fd, DRM_IOCTL_MODE_ADDFB, &fb_cmd) ? -errno : 0;
+		state.SetIterationTime(elapsed(start));
+
+		if (!ret)
+			ioctl(dri_fd, DRM_IOCTL_MODE_RMFB, &fb_cmd.fb_id);
+		gem_close(dri_fd, handle);
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	if (state.iterations())
+		state.counters["import_us"] = import_s * 1e6 / state.iterations();
+	close(buf_fd);
+}
+
+void register_prime_benchmarks(const std::vector<struct Heap> &heaps)
+{
+	/* Sizes are multiples of one 1024 pixel wide 32 bpp row */
+	static const int64_t minSize = 4 * 1024, maxSize = 32 * 1024 * 1024;
+
+	benchmark::RegisterBenchmark("PRIME/ExportDumb", BM_ExportDumb)
+		->RangeMultiplier(8)->Range(minSize, maxSize)->UseManualTime();
+
+	for (const struct Heap &heap : heaps) {
+		benchmark::RegisterBenchmark(("PRIME/Import/" + heap.name).c_str(), BM_Import, heap)
+			->RangeMultiplier(8)->Range(minSize, maxSize)->UseManualTime();
+		benchmark::RegisterBenchmark(("PRIME/ImportRepeat/" + heap.name).c_str(), BM_ImportRepeat, heap)
+			->RangeMultiplier(8)->Range(minSize, maxSize)->UseManualTime();
+		benchmark::RegisterBenchmark(("PRIME/Export/" + heap.name).c_str(), BM_Export, heap)
+			->RangeMultiplier(8)->Range(minSize, maxSize)->UseManualTime();
+		benchmark::RegisterBenchmark(("PRIME/ExportRepeat/" + heap.name).c_str(), BM_ExportRepeat, heap)
+			->RangeMultiplier(8)->Range(minSize, maxSize)->UseManualTime();
+		benchmark::RegisterBenchmark(("PRIME/AttachFb/" + heap.name).c_str(), BM_AttachFb, heap)
+			->RangeMultiplier(8)->Range(minSize, maxSize)->UseManualTime();
+	}
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <sys/mman.h>
+
+#include <benchmark/benchmark.h>
+
+#include "heap_bench.h"
+#include "heap_helper.h"
+#include "heap_stream.h"
+
+static const size_t streamBufferSize = 64 * 1024 * 1024;
+static const unsigned int streamWindows = 4;
+
+static uint64_t sum_words(const uint8_t *ptr, size_t len)
+{
+	const uint64_t *words = (const uint64_t *)ptr;
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < len / sizeof(uint64_t); i++)
+		sum += words[i];
+
+	return sum;
+}
+
+static void BM_FullMap(benchmark::State &state, struct Heap heap, bool write)
+{
+	int buf_fd = -1;
+	int ret = heap_alloc(heap.fd, streamBufferSize, 0, &buf_fd);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		return;
+	}
+
+	int prot = write ? PROT_WRITE : PROT_READ;
+	for (auto _ : state) {
+		void *ptr = mmap(NULL, streamBufferSize, prot, MAP_SHARED, buf_fd, 0);
+		if (ptr == MAP_FAILED) {
+			state.SkipWithError(strerror(errno));
+			break;
+		}
+
+		if (write)
+			memset(ptr, 0x5a, streamBufferSize);
+		else
+			benchmark::DoNotOptimize(sum_words((const uint8_t *)ptr, streamBufferSize));
+
+		munmap(ptr, streamBufferSize);
+	}
+
+	state.SetBytesProcessed(state.iterations() * streamBufferSize);
+	close(buf_fd);
+}
+
+static void BM_Stream(benchmark::State &state, struct Heap heap, bool write)
+{
+	size_t window = state.range(0);
+	bool prefetch = state.range(1);
+
+	int buf_fd = -1;
+	int ret = heap_alloc(heap.fd, streamBufferSize, 0, &buf_fd);
+	if (ret) {
+		state.SkipWithError(strerror(-ret));
+		return;
+	}
+
+	int prot = write ? PROT_WRITE : PROT_READ;
+	struct HeapStream::Stats stats = { 0, 0, 0 };
+	for (auto _ : state) {
+		HeapStream stream;
+		ret = stream.open(buf_fd, streamBufferSize, window, streamWindows, prot, prefetch);
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+
+		if (write) {
+			for (auto &chunk : stream.write())
+				memset(chunk.data(), 0x5a, chunk.size());
+		} else {
+			uint64_t sum = 0;
+			for (auto &chunk : stream.read())
+				sum += sum_words(chunk.data(), chunk.size());
+			benchmark::DoNotOptimize(sum);
+		}
+		/* the pass stopped early, it did not process the whole buffer */
+		ret = stream.error();
+		if (ret) {
+			state.SkipWithError(strerror(-ret));
+			break;
+		}
+
+		struct HeapStream::Stats s = stream.stats();
+		stats.maps += s.maps;
+		stats.prefetched += s.prefetched;
+	}
+
+	state.SetBytesProcessed(state.iterations() * streamBufferSize);
+	state.counters["maps"] = benchmark::Counter(stats.maps, benchmark::Counter::kAvgIterations);
+	state.counters["prefetched"] = benchmark::Counter(stats.prefetched, benchmark::Counter::kAvgIterations);
+	close(buf_fd);
+}
+
+void register_stream_benchmarks(const std::vector<struct Heap> &heaps)
+{
+	for (const struct Heap &heap : heaps) {
+		benchmark::RegisterBenchmark(("Stream/FullMap/Read/" + heap.name).c_str(),
+					     BM_FullMap, heap, false)
+			->UseRealTime();
+		benchmark::RegisterBenchmark(("Stream/FullMap/Write/" + heap.name).c_str(),
+					     BM_FullMap, heap, true)
+			->UseRealTime();
+		benchmark::RegisterBenchmark(("Stream/Window/Read/" + heap.name).c_str(),
+					     BM_Stream, heap, false)
+			->ArgsProduct({ benchmark::CreateRange(64 * 1024, 4 * 1024 * 1024, 4), { 0, 1 } })
+			->ArgNames({ "window", "prefetch" })
+			->UseRealTime();
+		benchmark::RegisterBenchmark(("Stream/Window/Write/" + heap.name).c_str(),
+					     BM_Stream, heap, true)
+			->ArgsProduct({ benchmark::CreateRange(64 * 1024, 4 * 1024 * 1024, 4), { 0, 1 } })
+			->ArgNames({ "window", "prefetch" })
+			->UseRealTime();
+	}
+}
@@ -21,8 +21,11 @@
 #include <string.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <math.h>
+#include <poll.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
+#include <time.h>
 #include <unistd.h>
 #include <drm/drm.h>
 #include <drm/drm_mode.h>
@@ -30,6 +33,10 @@
 #include <linux/dma-buf.h>
 #include <linux/dma-heap.h>
 
+#include "heap_helper.h"
+#include "heap_kernels.h"
+#include "pattern_helper.h"
+
 //#define DUMB_BUFFERS
 //#define TEST_PHYS
 
@@ -37,97 +44,10 @@
 #include <linux/remoteproc_cdev.h>
 #endif
 
-#define MAKE_RGBA(r, g, b, a) \
-	(((a) << 24) | \
-	 ((r) << 16) | \
-	 ((g) <<  8) | \
-	 ((b) <<  0))
-
-static void fill_smpte_rgb32(void *mem,
-			     unsigned int width, unsigned int height,
-			     unsigned int stride)
-{
-	const uint32_t colors_top[] = {
-		MAKE_RGBA(192, 192, 192, 255),	/* grey */
-		MAKE_RGBA(192, 192, 0, 255),	/* yellow */
-		MAKE_RGBA(0, 192, 192, 255),	/* cyan */
-		MAKE_RGBA(0, 192, 0, 255),	/* green */
-		MAKE_RGBA(192, 0, 192, 255),	/* magenta */
-		MAKE_RGBA(192, 0, 0, 255),	/* red */
-		MAKE_RGBA(0, 0, 192, 255),	/* blue */
-	};
-	const uint32_t colors_middle[] = {
-		MAKE_RGBA(0, 0, 192, 127),	/* blue */
-		MAKE_RGBA(19, 19, 19, 127),	/* black */
-		MAKE_RGBA(192, 0, 192, 127),	/* magenta */
-		MAKE_RGBA(19, 19, 19, 127),	/* black */
-		MAKE_RGBA(0, 192, 192, 127),	/* cyan */
-		MAKE_RGBA(19, 19, 19, 127),	/* black */
-		MAKE_RGBA(192, 192, 192, 127),	/* grey */
-	};
-	const uint32_t colors_bottom[] = {
-		MAKE_RGBA(0, 33, 76, 255),	/* in-phase */
-		MAKE_RGBA(255, 255, 255, 255),	/* super white */
-		MAKE_RGBA(50, 0, 106, 255),	/* quadrature */
-		MAKE_RGBA(19, 19, 19, 255),	/* black */
-		MAKE_RGBA(9, 9, 9, 255),	/* 3.5% */
-		MAKE_RGBA(19, 19, 19, 255),	/* 7.5% */
-		MAKE_RGBA(29, 29, 29, 255),	/* 11.5% */
-		MAKE_RGBA(19, 19, 19, 255),	/* black */
-	};
-	unsigned int x;
-	unsigned int y;
-
-	for (y = 0; y < height * 6 / 9; ++y) {
-		for (x = 0; x < width; ++x)
-			((uint32_t *)mem)[x] = colors_top[x * 7 / width];
-		mem += stride;
-	}
-
-	for (; y < height * 7 / 9; ++y) {
-		for (x = 0; x < width; ++x)
-			((uint32_t *)mem)[x] = colors_middle[x * 7 / width];
-		mem += stride;
-	}
-
-	for (; y < height; ++y) {
-		for (x = 0; x < width * 5 / 7; ++x)
-			((uint32_t *)mem)[x] =
-				colors_bottom[x * 4 / (width * 5 / 7)];
-		for (; x < width * 6 / 7; ++x)
-			((uint32_t *)mem)[x] =
-				colors_bottom[(x - width * 5 / 7) * 3
-					      / (width / 7) + 4];
-		for (; x < width; ++x)
-			((uint32_t *)mem)[x] = colors_bottom[7];
-		mem += stride;
-	}
-}
-
-static int heap_alloc(int fd, size_t len, unsigned int flags, int* handle_fd)
-{
-	if (handle_fd == NULL)
-		return -EINVAL;
-
-	struct dma_heap_allocation_data data = {
-		.len = len,
-		.fd_flags = O_CLOEXEC | O_RDWR,
-		.heap_flags = flags,
-	};
-
-	int ret = ioctl(fd, DMA_HEAP_IOCTL_ALLOC, &data);
-	if (ret < 0)
-		return errno;
-
-	*handle_fd = data.fd;
-
-	return 0;
-}
-
-static void dmabuf_sync(int fd, int start_stop)
+static void dmabuf_sync(int fd, int flags)
 {
 	struct dma_buf_sync sync = {
-		.flags = start_stop | DMA_BUF_SYNC_WRITE,
+		.flags = flags,
 	};
 	int ret;
 
@@ -168,48 +88,94 @@ int get_phys_rproc(int fd, u_int64_t *phys)
 }
 #endif
 
-static uint32_t allocate_attach_fb(int dri_fd, uint width, uint height, char *heap_dev)
+// Returns the DMA-BUF fd or a negative errno, the error is already reported
+static int heap_buffer_alloc(const char *heap_dev, size_t size)
+{
+	int heap_fd = open(heap_dev, O_RDONLY | O_CLOEXEC);
+	if (heap_fd < 0) {
+		int ret = -errno;
+		printf("%s: Failed to open DMA-Heap device: %s\n", heap_dev, strerror(errno));
+		return ret;
+	}
+
+	int dma_buf_fd = -1;
+	int ret = heap_alloc(heap_fd, size, 0, &dma_buf_fd);
+	close(heap_fd);
+	if (ret) {
+		printf("%s: DMA-Heap allocation of %zu bytes failed: %s\n", heap_dev, size, strerror(-ret));
+		return ret;
+	}
+
+	return dma_buf_fd;
+}
+
+struct framebuffer {
+	uint32_t fb_id;
+	int dma_buf_fd;
+	void *map;
+	const struct pattern_format *format;
+	struct pattern_layout layout;
+	unsigned int width;
+	unsigned int height;
+	const struct heap_kernels *kernels;
+	// Lines are built here, allocated once so no frame pays for it
+	void *scratch;
+};
+
+static void fill_fb(struct framebuffer *fb, unsigned int offset)
+{
+	pattern_fill_smpte(fb->kernels, fb->format, &fb->layout, fb->map,
+			   fb->width, fb->height, offset, fb->scratch);
+}
+
+static void render_fb(struct framebuffer *fb, unsigned int offset)
+{
+	if (fb->dma_buf_fd >= 0)
+		dmabuf_sync(fb->dma_buf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+
+	fill_fb(fb, offset);
+
+	if (fb->dma_buf_fd >= 0)
+		dmabuf_sync(fb->dma_buf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+}
+
+static void allocate_attach_fb(int dri_fd, uint width, uint height, char *heap_dev,
+			       const struct pattern_format *format, struct framebuffer *fb)
 {
+	struct pattern_layout layout;
 	uint32_t handle;
+	unsigned int p;
 
-	size_t bpp = 32;
-	size_t pitch = width * (bpp / 8);
-	size_t size = height * pitch;
+	if (pattern_layout_get(format, width, height, &layout)) {
+		printf("Cannot lay out %s at %ux%u\n", format->name, width, height);
+		exit(EXIT_FAILURE);
+	}
+	size_t size = layout.size;
 
-	printf("Buffer: bpp: %zd, pitch: %zd, size: %zd\n", bpp, pitch, size);
+	printf("Buffer: format: %s, size: %zd\n", format->name, size);
+	for (p = 0; p < format->num_planes; p++)
+		printf("  plane %u: pitch: %u, offset: %u\n", p, layout.pitches[p], layout.offsets[p]);
 
 #ifdef DUMB_BUFFERS
-	// Create dumb buffer
+	// Create dumb buffer, only used as linear memory holding all planes
 	struct drm_mode_create_dumb create_dumb = { 0 };
-	create_dumb.width = width;
-	create_dumb.height = height;
-	create_dumb.bpp = 32;
+	create_dumb.width = layout.pitches[0];
+	create_dumb.height = (size + layout.pitches[0] - 1) / layout.pitches[0];
+	create_dumb.bpp = 8;
 	create_dumb.flags = 0;
 	ioctl(dri_fd, DRM_IOCTL_MODE_CREATE_DUMB, &create_dumb);
 
 	printf("Created dumb buffer with size: %llu, pitch: %u, and handle: %u\n", create_dumb.size, create_dumb.pitch, create_dumb.handle);
 
 	handle = create_dumb.handle;
+	int dma_buf_fd = -1;
 #else
 	// Create DMA-BUF from Heaps allocator
-	int heap_fd = open(heap_dev, O_RDONLY | O_CLOEXEC);
-	if (heap_fd < 0) {
-		printf("Failed to open DMA-Heap device: %s\n", strerror(errno));
-		exit(EXIT_FAILURE);
-	}
+	int dma_buf_fd = heap_buffer_alloc(heap_dev, size);
+	int ret;
 
-	int dma_buf_fd;
-	int ret = heap_alloc(heap_fd, size, 0, &dma_buf_fd);
-	if (ret) {
-		printf("DMA-Heap allocation failed: %s\n", strerror(ret));
+	if (dma_buf_fd < 0)
 		exit(EXIT_FAILURE);
-	}
-
-	ret = close(heap_fd);
-	if (ret < 0) {
-		printf("Failed to close DMA-Heap device: %s\n", strerror(errno));
-		exit(EXIT_FAILURE);
-	}
 
 #ifdef TEST_PHYS
 	u_int64_t phys;
@@ -226,25 +192,36 @@ static uint32_t allocate_attach_fb(int dri_fd, uint width, uint height, char *he
 	prime_to_handle.fd = dma_buf_fd;
 	ret = ioctl(dri_fd, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime_to_handle);
 	if (ret) {
-		printf("Could not convert prime fd to handle: %s\n", strerror(ret));
+		printf("Could not convert prime fd to handle: %s\n", strerror(errno));
 		exit(EXIT_FAILURE);
 	}
 	handle = prime_to_handle.handle;
 #endif
 
-	// Attach buffer to plane
-	struct drm_mode_fb_cmd fb_cmd = { 0 };
+	// Attach buffer to plane, every format plane lives in the same buffer
+	struct drm_mode_fb_cmd2 fb_cmd = { 0 };
 	fb_cmd.width = width;
 	fb_cmd.height = height;
-	fb_cmd.bpp = bpp;
-	fb_cmd.pitch = pitch;
-	fb_cmd.depth = 24;
-	fb_cmd.handle = handle;
-	ioctl(dri_fd, DRM_IOCTL_MODE_ADDFB, &fb_cmd);
+	fb_cmd.pixel_format = format->fourcc;
+	for (p = 0; p < format->num_planes; p++) {
+		fb_cmd.handles[p] = handle;
+		fb_cmd.pitches[p] = layout.pitches[p];
+		fb_cmd.offsets[p] = layout.offsets[p];
+	}
+	if (ioctl(dri_fd, DRM_IOCTL_MODE_ADDFB2, &fb_cmd)) {
+		printf("Could not add %s framebuffer: %s\n", format->name, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
 
 	printf("Buffer added to FB: %u\n", fb_cmd.fb_id);
 
 	// Map buffer to userspace
+#ifndef DUMB_BUFFERS
+	// The FB holds its own reference, the imported handle is not needed anymore
+	struct drm_gem_close gem_close = { 0 };
+	gem_close.handle = handle;
+	ioctl(dri_fd, DRM_IOCTL_GEM_CLOSE, &gem_close);
+#endif
 #ifdef DUMB_BUFFERS
 	struct drm_mode_map_dumb map_dumb = { 0 };
 	map_dumb.handle = handle;
@@ -258,29 +235,554 @@ static uint32_t allocate_attach_fb(int dri_fd, uint width, uint height, char *he
 		exit(EXIT_FAILURE);
 	}
 
-	dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_START);
+	fb->fb_id = fb_cmd.fb_id;
+	fb->dma_buf_fd = dma_buf_fd;
+	fb->map = fb_base;
+	fb->format = format;
+	fb->layout = layout;
+	fb->width = width;
+	fb->height = height;
+	if (dma_buf_fd >= 0)
+		dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+	fb->kernels = heap_kernels_select(fb_base, size);
+	if (dma_buf_fd >= 0)
+		dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+	printf("Fill kernels: %s\n", fb->kernels->name);
+	fb->scratch = malloc(pattern_scratch_bytes(width));
+	if (!fb->scratch) {
+		printf("Failed to allocate line buffers\n");
+		exit(EXIT_FAILURE);
+	}
 
 	// Fill with test pattern
-	fill_smpte_rgb32(fb_base, width, height, pitch);
+	render_fb(fb, 0);
+}
 
-	dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_END);
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * FNV-1a over 64-bit words in four interleaved lanes so the multiplies
+ * do not serialize. Rows are pulled through the read kernel as the
+ * mapping may be uncached.
+ */
+static uint64_t checksum_frame(const struct heap_kernels *kernels, const void *mem,
+			       size_t row_bytes, unsigned int height, size_t stride,
+			       uint64_t *line)
+{
+	uint64_t lanes[4] = {
+		0xcbf29ce484222325ULL, 0xcbf29ce484222325ULL,
+		0xcbf29ce484222325ULL, 0xcbf29ce484222325ULL,
+	};
+	size_t words = row_bytes / sizeof(uint64_t);
+	unsigned int y;
+	size_t x;
+
+	for (y = 0; y < height; y++) {
+		kernels->read(line, mem, row_bytes);
+		for (x = 0; x + 4 <= words; x += 4) {
+			lanes[0] = (lanes[0] ^ line[x + 0]) * 0x100000001b3ULL;
+			lanes[1] = (lanes[1] ^ line[x + 1]) * 0x100000001b3ULL;
+			lanes[2] = (lanes[2] ^ line[x + 2]) * 0x100000001b3ULL;
+			lanes[3] = (lanes[3] ^ line[x + 3]) * 0x100000001b3ULL;
+		}
+		for (; x < words; x++)
+			lanes[0] = (lanes[0] ^ line[x]) * 0x100000001b3ULL;
+		if (row_bytes % sizeof(uint64_t)) {
+			uint64_t tail = 0;
+			memcpy(&tail, &line[words], row_bytes % sizeof(uint64_t));
+			lanes[1] = (lanes[1] ^ tail) * 0x100000001b3ULL;
+		}
+		mem += stride;
+	}
+
+	return lanes[0] ^ (lanes[1] << 1) ^ (lanes[2] << 2) ^ (lanes[3] << 3);
+}
+
+/* Find a software DRM driver (vgem or vkms) we can PRIME import into */
+static int open_virtual_drm(void)
+{
+	char path[32];
+	int i;
+
+	for (i = 0; i < 64; i++) {
+		char name[32] = { 0 };
+		struct drm_version version = { 0 };
+
+		snprintf(path, sizeof(path), "/dev/dri/card%d", i);
+		int fd = open(path, O_RDWR | O_CLOEXEC);
+		if (fd < 0)
+			continue;
+
+		version.name = name;
+		version.name_len = sizeof(name) - 1;
+		if (!ioctl(fd, DRM_IOCTL_VERSION, &version) &&
+		    (!strcmp(name, "vgem") || !strcmp(name, "vkms"))) {
+			printf("Importing into %s (%s)\n", name, path);
+			return fd;
+		}
+		close(fd);
+	}
+
+	return -1;
+}
+
+/* Import a DMA-BUF and drop the GEM handle again, returns 0 or -errno */
+static int prime_import_release(int dri_fd, int dma_buf_fd)
+{
+	struct drm_prime_handle prime_to_handle = { 0 };
+	prime_to_handle.fd = dma_buf_fd;
+	if (ioctl(dri_fd, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime_to_handle))
+		return -errno;
+
+	struct drm_gem_close gem_close = { 0 };
+	gem_close.handle = prime_to_handle.handle;
+	if (ioctl(dri_fd, DRM_IOCTL_GEM_CLOSE, &gem_close))
+		return -errno;
+
+	return 0;
+}
+
+/* Checksum of every plane, the row padding is left out */
+static uint64_t checksum_fb(const struct heap_kernels *kernels, const struct pattern_format *format,
+			    const struct pattern_layout *layout, const void *mem,
+			    unsigned int width, unsigned int height, uint64_t *line)
+{
+	uint64_t sum = 0;
+	unsigned int p;
+
+	for (p = 0; p < format->num_planes; p++)
+		sum = ((sum << 7) | (sum >> 57)) ^
+		      checksum_frame(kernels, mem + layout->offsets[p],
+				     pattern_row_bytes(format, p, width),
+				     pattern_rows(format, p, height), layout->pitches[p], line);
+
+	return sum;
+}
+
+/*
+ * Render frames of one format into a buffer from the heap, returns the
+ * number of frames whose checksum did not match the first one, or 1 if
+ * the buffer could not be allocated or mapped. Fill rates
+ * count only the pixel data, so formats with fewer bytes per pixel show
+ * up as a higher pixel rate for the same memory bandwidth.
+ */
+static unsigned int render_headless(const char *heap_dev, const struct pattern_format *format,
+				    unsigned int width, unsigned int height,
+				    unsigned int frames, int *import_fd, uint64_t *line,
+				    void *scratch)
+{
+	struct pattern_layout layout;
+
+	if (pattern_layout_get(format, width, height, &layout)) {
+		printf("%s: %s does not fit %ux%u, skipped\n", heap_dev, format->name, width, height);
+		return 0;
+	}
+	size_t size = layout.size;
+	size_t frame_bytes = pattern_frame_bytes(format, width, height);
+
+	// A heap that fails only fails its own report, the other heaps still run
+	int dma_buf_fd = heap_buffer_alloc(heap_dev, size);
+	if (dma_buf_fd < 0)
+		return 1;
+	void *fb_base = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, dma_buf_fd, 0);
+	if (fb_base == MAP_FAILED) {
+		printf("%s: Could not mmap buffer: %s\n", heap_dev, strerror(errno));
+		close(dma_buf_fd);
+		return 1;
+	}
+
+	dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+	const struct heap_kernels *kernels = heap_kernels_select(fb_base, size);
+	dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+	uint64_t import_ns = 0, fill_ns = 0, sum_ns = 0;
+	uint64_t reference = 0;
+	unsigned int mismatches = 0;
+	unsigned int f;
+
+	uint64_t start = now_ns();
+	for (f = 0; f < frames; f++) {
+		uint64_t t0 = now_ns();
+
+		if (*import_fd >= 0) {
+			int ret = prime_import_release(*import_fd, dma_buf_fd);
+			if (ret) {
+				printf("PRIME import failed: %s\n", strerror(-ret));
+				close(*import_fd);
+				*import_fd = -1;
+			}
+		}
+		uint64_t t1 = now_ns();
+
+		dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+		pattern_fill_smpte(kernels, format, &layout, fb_base, width, height, 0, scratch);
+		dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+		uint64_t t2 = now_ns();
+
+		dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+		uint64_t sum = checksum_fb(kernels, format, &layout, fb_base, width, height, line);
+		dmabuf_sync(dma_buf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+		uint64_t t3 = now_ns();
+
+		if (f == 0)
+			reference = sum;
+		else if (sum != reference)
+			mismatches++;
+
+		import_ns += t1 - t0;
+		fill_ns += t2 - t1;
+		sum_ns += t3 - t2;
+	}
+	double total_s = (now_ns() - start) / 1e9;
+
+	printf("%s %s: kernels %s, %u frames in %.3f s, %.1f fps, fill %.2f GB/s %.1f Mpixel/s, checksum %.2f GB/s",
+	       heap_dev, format->name, kernels->name, frames, total_s, frames / total_s,
+	       (double)frame_bytes * frames / fill_ns,
+	       (double)width * height * frames * 1e3 / fill_ns,
+	       (double)frame_bytes * frames / sum_ns);
+	if (*import_fd >= 0)
+		printf(", import %.1f us", import_ns / 1e3 / frames);
+	printf(", checksum 0x%016llx, %u mismatched frames\n",
+	       (unsigned long long)reference, mismatches);
 
 	munmap(fb_base, size);
+	close(dma_buf_fd);
+
+	return mismatches;
+}
+
+/*
+ * Render the test pattern frame after frame into a buffer from each heap,
+ * no KMS device is needed. Every frame is synced for CPU access, filled,
+ * checksummed and compared against the first frame's checksum. Without a
+ * format every supported one is rendered in turn.
+ */
+static int run_headless(char **heap_devs, int count, const struct pattern_format *format,
+			unsigned int width, unsigned int height, unsigned int frames, int import)
+{
+	const struct pattern_format *f;
+	int failed = 0;
+	int import_fd = -1;
+	unsigned int n;
+	int i;
+
+	printf("Headless: %ux%u, frames: %u\n", width, height, frames);
+
+	if (import) {
+		import_fd = open_virtual_drm();
+		if (import_fd < 0)
+			printf("No vgem or vkms device found, not importing\n");
+	}
+
+	// Large enough for the widest row of any format, in whole words
+	uint64_t *line = malloc(PATTERN_ALIGN(width * sizeof(uint32_t), sizeof(uint64_t)));
+	void *scratch = malloc(pattern_scratch_bytes(width));
+	if (!line || !scratch) {
+		printf("Failed to allocate line buffers\n");
+		exit(EXIT_FAILURE);
+	}
 
-	return fb_cmd.fb_id;
+	for (i = 0; i < count; i++) {
+		if (format) {
+			if (render_headless(heap_devs[i], format, width, height, frames, &import_fd, line,
+					    scratch))
+				failed = 1;
+			continue;
+		}
+		for (n = 0; (f = pattern_format_get(n)); n++)
+			if (render_headless(heap_devs[i], f, width, height, frames, &import_fd, line,
+					    scratch))
+				failed = 1;
+	}
+
+	free(line);
+	free(scratch);
+	if (import_fd >= 0)
+		close(import_fd);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+struct stage_stats {
+	uint64_t total;
+	uint64_t min;
+	uint64_t max;
+	double sum_sq;
+	unsigned int count;
+};
+
+static void stats_add(struct stage_stats *stats, uint64_t ns)
+{
+	if (!stats->count || ns < stats->min)
+		stats->min = ns;
+	if (ns > stats->max)
+		stats->max = ns;
+	stats->total += ns;
+	stats->sum_sq += (double)ns * ns;
+	stats->count++;
+}
+
+static void stats_print(const char *name, const struct stage_stats *stats)
+{
+	if (!stats->count)
+		return;
+
+	double avg = (double)stats->total / stats->count;
+	double var = stats->sum_sq / stats->count - avg * avg;
+
+	printf("  %-6s avg %8.3f ms, min %8.3f ms, max %8.3f ms, stddev %8.3f ms\n",
+	       name, avg / 1e6, stats->min / 1e6, stats->max / 1e6,
+	       (var > 0 ? sqrt(var) : 0) / 1e6);
+}
+
+/* Wait for the next page flip completion event on the DRM fd */
+static int wait_flip(int dri_fd, struct drm_event_vblank *vblank)
+{
+	char buf[1024];
+
+	for (;;) {
+		struct pollfd pfd = { .fd = dri_fd, .events = POLLIN };
+		int ret = poll(&pfd, 1, 1000);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			return -errno;
+		if (ret == 0)
+			return -ETIMEDOUT;
+
+		ssize_t len = read(dri_fd, buf, sizeof(buf));
+		if (len < 0)
+			return -errno;
+
+		int found = 0;
+		ssize_t i;
+		for (i = 0; i + (ssize_t)sizeof(struct drm_event) <= len;) {
+			struct drm_event *event = (struct drm_event *)&buf[i];
+			if (event->type == DRM_EVENT_FLIP_COMPLETE) {
+				memcpy(vblank, event, sizeof(*vblank));
+				found = 1;
+			}
+			if (!event->length)
+				break;
+			i += event->length;
+		}
+		if (found)
+			return 0;
+	}
+}
+
+struct flip_state {
+	int scanout;
+	int pending;
+	uint64_t flip_start;
+	uint64_t last_ts;
+	uint32_t last_seq;
+	unsigned int flips;
+	unsigned int late_frames;
+	unsigned int missed_vblanks;
+	struct stage_stats flip;
+	struct stage_stats frame;
+};
+
+static int complete_flip(int dri_fd, struct flip_state *state)
+{
+	struct drm_event_vblank vblank;
+	int ret = wait_flip(dri_fd, &vblank);
+	if (ret)
+		return ret;
+
+	// Every flip is waited for before the next is queued, the event must be for the pending one
+	if (vblank.user_data != (uint64_t)state->pending)
+		return -EPROTO;
+
+	// Both CLOCK_MONOTONIC, independent of how late the event is read
+	uint64_t ts = (uint64_t)vblank.tv_sec * 1000000000ULL + vblank.tv_usec * 1000ULL;
+	stats_add(&state->flip, ts > state->flip_start ? ts - state->flip_start : 0);
+	if (state->flips) {
+		stats_add(&state->frame, ts - state->last_ts);
+		if (vblank.sequence - state->last_seq > 1) {
+			state->late_frames++;
+			state->missed_vblanks += vblank.sequence - state->last_seq - 1;
+		}
+	}
+	state->last_ts = ts;
+	state->last_seq = vblank.sequence;
+	state->flips++;
+
+	state->scanout = state->pending;
+	state->pending = -1;
+
+	return 0;
+}
+
+/*
+ * Cycle the framebuffers through page flips: while one is scanned out and
+ * another possibly waits for its flip, animate the pattern into a free one
+ * and queue it as soon as the previous flip has landed. Frame times and
+ * flip latencies come from the flip event timestamps, so they do not
+ * include rendering done before the event is read. A gap of more than one
+ * vblank sequence between consecutive flips is a missed refresh.
+ */
+static int run_flip_loop(int dri_fd, uint32_t crtc_id, struct framebuffer *fbs,
+			 unsigned int count, unsigned int frames, uint32_t vrefresh)
+{
+	struct flip_state state = { .scanout = 0, .pending = -1 };
+	struct stage_stats fill = { 0 }, sync = { 0 };
+	int next = 0;
+	unsigned int f;
+	int ret;
+
+	printf("Flipping %u frames through %u buffers at %u Hz\n", frames, count, vrefresh);
+
+	for (f = 1; f <= frames; f++) {
+		// With two buffers both are busy until the pending flip lands
+		do {
+			next = (next + 1) % count;
+		} while (next == state.scanout || next == state.pending);
+
+		struct framebuffer *fb = &fbs[next];
+		uint64_t t0 = now_ns();
+		if (fb->dma_buf_fd >= 0)
+			dmabuf_sync(fb->dma_buf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+		uint64_t t1 = now_ns();
+		fill_fb(fb, f * 8);
+		uint64_t t2 = now_ns();
+		if (fb->dma_buf_fd >= 0)
+			dmabuf_sync(fb->dma_buf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+		uint64_t t3 = now_ns();
+		stats_add(&fill, t2 - t1);
+		stats_add(&sync, (t1 - t0) + (t3 - t2));
+
+		if (state.pending >= 0) {
+			ret = complete_flip(dri_fd, &state);
+			if (ret) {
+				printf("Waiting for page flip failed: %s\n", strerror(-ret));
+				return EXIT_FAILURE;
+			}
+		}
+
+		struct drm_mode_crtc_page_flip page_flip = { 0 };
+		page_flip.crtc_id = crtc_id;
+		page_flip.fb_id = fb->fb_id;
+		page_flip.flags = DRM_MODE_PAGE_FLIP_EVENT;
+		page_flip.user_data = next;
+		state.flip_start = now_ns();
+		if (ioctl(dri_fd, DRM_IOCTL_MODE_PAGE_FLIP, &page_flip)) {
+			printf("Page flip failed: %s\n", strerror(errno));
+			return EXIT_FAILURE;
+		}
+		state.pending = next;
+
+		// Triple buffering: a free buffer can be rendered while this flip is in flight
+		if (count < 3) {
+			ret = complete_flip(dri_fd, &state);
+			if (ret) {
+				printf("Waiting for page flip failed: %s\n", strerror(-ret));
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	if (state.pending >= 0 && complete_flip(dri_fd, &state))
+		printf("Waiting for last page flip failed\n");
+
+	printf("Frames: %u, late frames: %u, missed vblanks: %u\n",
+	       state.flips, state.late_frames, state.missed_vblanks);
+	if (vrefresh)
+		printf("  target %8.3f ms per frame\n", 1e3 / vrefresh);
+	stats_print("frame", &state.frame);
+	stats_print("fill", &fill);
+	stats_print("sync", &sync);
+	stats_print("flip", &state.flip);
+
+	return state.missed_vblanks ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage %s [-d card] [-f format] [-F buffers] [-n frames] /dev/dma_heap/<heap device>\n", name);
+	printf("      %s -H [-f format] [-n frames] [-s WxH] [-i] /dev/dma_heap/<heap device> [...]\n", name);
+	printf("  -d card    DRM device to display on (default /dev/dri/card0)\n");
+	printf("  -f format  XRGB8888 (default), RGB565, YUYV or NV12, or all when headless\n");
+	printf("  -F buffers animate through 2 or 3 page flipped buffers and report frame timing\n");
+	printf("  -H         headless, render into heap buffers without KMS, one or more heaps\n");
+	printf("  -n frames  frames to flip, or to render per heap when headless (default 300)\n");
+	printf("  -s WxH     frame size when headless (default 1920x1080)\n");
+	printf("  -i         PRIME import every frame into vgem or vkms when headless\n");
 }
 
 #define MAX_CONNECTORS 40
 #define MAX_MODES 40
+#define MAX_FLIP_BUFFERS 3
 
 int main(int argc, char* argv[])
 {
-	if (argc != 2) {
-		printf("Usage %s /dev/dma_heap/<heap device>\n", argv[0]);
+	unsigned int width = 1920, height = 1080, frames = 300;
+	unsigned int flip_buffers = 0;
+	const char *card = "/dev/dri/card0";
+	const struct pattern_format *format = pattern_format_get(0);
+	int headless = 0, import = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:f:F:Hn:s:i")) != -1) {
+		switch (opt) {
+		case 'd':
+			card = optarg;
+			break;
+		case 'f':
+			// NULL selects every format, only when headless
+			format = strcasecmp(optarg, "all") ? pattern_format_find(optarg) : NULL;
+			if (!format && strcasecmp(optarg, "all")) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'F':
+			flip_buffers = strtoul(optarg, NULL, 0);
+			if (flip_buffers < 2 || flip_buffers > MAX_FLIP_BUFFERS) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'H':
+			headless = 1;
+			break;
+		case 'n':
+			frames = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			if (sscanf(optarg, "%ux%u", &width, &height) != 2) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'i':
+			import = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (headless && optind < argc && frames && width && height)
+		return run_headless(&argv[optind], argc - optind, format, width, height, frames, import);
+
+	if (headless || !format || optind != argc - 1 || (flip_buffers && !frames)) {
+		usage(argv[0]);
 		return EXIT_FAILURE;
 	}
 
-	int dri_fd = open("/dev/dri/card0", O_RDWR | O_CLOEXEC);
+	int dri_fd = open(card, O_RDWR | O_CLOEXEC);
+	if (dri_fd < 0) {
+		printf("Failed to open DRM device %s: %s\n", card, strerror(errno));
+		return EXIT_FAILURE;
+	}
 
 	// Become the DRM device master
 	ioctl(dri_fd, DRM_IOCTL_SET_MASTER, 0);
@@ -327,7 +829,10 @@ int main(int argc, char* argv[])
 	printf("Using connector default mode: %dx%d\n", conn_mode_buf[0].hdisplay, conn_mode_buf[0].vdisplay);
 
 	// All the buffer handling
-	uint32_t fb_id = allocate_attach_fb(dri_fd, conn_mode_buf[0].hdisplay, conn_mode_buf[0].vdisplay, argv[1]);
+	struct framebuffer fbs[MAX_FLIP_BUFFERS];
+	unsigned int fb_count = flip_buffers ? flip_buffers : 1;
+	for (i = 0; i < fb_count; i++)
+		allocate_attach_fb(dri_fd, conn_mode_buf[0].hdisplay, conn_mode_buf[0].vdisplay, argv[optind], format, &fbs[i]);
 
 	// Get current CRTC for our encoder
 	struct drm_mode_get_encoder enc = { 0 };
@@ -340,13 +845,19 @@ int main(int argc, char* argv[])
 	ioctl(dri_fd, DRM_IOCTL_MODE_GETCRTC, &crtc);
 
 	// Setup CRTC
-	crtc.fb_id = fb_id;
+	crtc.fb_id = fbs[0].fb_id;
 	crtc.set_connectors_ptr = (uint64_t)(uintptr_t)&conn.connector_id;
 	crtc.count_connectors = 1;
 	crtc.mode = conn_mode_buf[0];
 	crtc.mode_valid = 1;
 	ioctl(dri_fd, DRM_IOCTL_MODE_SETCRTC, &crtc);
 
+	if (flip_buffers) {
+		int ret = run_flip_loop(dri_fd, crtc.crtc_id, fbs, fb_count, frames, crtc.mode.vrefresh);
+		ioctl(dri_fd, DRM_IOCTL_DROP_MASTER, 0);
+		return ret;
+	}
+
 	// Stop being DRM device master
 	ioctl(dri_fd, DRM_IOCTL_DROP_MASTER, 0);
 
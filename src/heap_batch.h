@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HEAP_BATCH_H_
+#define HEAP_BATCH_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "heap_helper.h"
+
+/*
+ * Allocates a whole set of buffers, such as a swapchain or a decoder's
+ * frame pool, from one or more heaps at once. The requests are shared out
+ * over a pool of worker threads kept for the lifetime of the object, the
+ * calling thread works along with them.
+ *
+ * In all-or-nothing mode the first failure stops any requests not yet
+ * started and every buffer already allocated is closed again, so a
+ * failed batch leaves nothing behind. In best-effort mode every request
+ * is tried and the successful ones are kept.
+ */
+class HeapBatch {
+public:
+	enum Mode {
+		BATCH_ALL_OR_NOTHING,
+		BATCH_BEST_EFFORT,
+	};
+
+	struct Request {
+		int heap_fd;
+		size_t len;
+		unsigned int flags;
+	};
+
+	/* fd is -1 whenever error is set */
+	struct Result {
+		int fd;
+		int error;
+	};
+
+	/* Same contract as heap_alloc(), used to inject faults */
+	typedef std::function<int(int heap_fd, size_t len, unsigned int flags, int *dmabuf_fd)> AllocFn;
+
+	/* threads counts the calling thread, 0 for one per CPU */
+	explicit HeapBatch(unsigned int threads = 0, AllocFn alloc = AllocFn());
+	~HeapBatch();
+
+	HeapBatch(const HeapBatch &) = delete;
+	HeapBatch &operator=(const HeapBatch &) = delete;
+
+	/*
+	 * One result per request, in order. Returns 0 if every request was
+	 * served, otherwise the error of the first failed request. Requests
+	 * skipped after a failure in all-or-nothing mode fail with -ECANCELED.
+	 */
+	int allocate(const std::vector<struct Request> &requests, enum Mode mode,
+		     std::vector<struct Result> *results);
+
+	/* Close every buffer in results */
+	static void release(std::vector<struct Result> *results);
+
+	unsigned int threads() const { return m_workers.size() + 1; }
+
+private:
+	void run();
+	void worker();
+
+	AllocFn m_alloc;
+	std::vector<std::thread> m_workers;
+
+	/* one batch at a time */
+	std::mutex m_batchLock;
+
+	std::mutex m_lock;
+	std::condition_variable m_cond;
+	std::condition_variable m_doneCond;
+	unsigned long m_generation;
+	unsigned int m_busy;
+	bool m_stop;
+
+	/* the batch being worked on */
+	const std::vector<struct Request> *m_requests;
+	std::vector<struct Result> *m_results;
+	enum Mode m_mode;
+	std::atomic<size_t> m_next;
+	std::atomic<bool> m_failed;
+};
+
+inline HeapBatch::HeapBatch(unsigned int threads, AllocFn alloc) :
+	m_alloc(alloc), m_generation(0), m_busy(0), m_stop(false),
+	m_requests(nullptr), m_results(nullptr), m_mode(BATCH_BEST_EFFORT),
+	m_next(0), m_failed(false)
+{
+	if (!m_alloc)
+		m_alloc = heap_alloc;
+	if (!threads)
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (unsigned int i = 1; i < threads; i++)
+		m_workers.emplace_back(&HeapBatch::worker, this);
+}
+
+inline HeapBatch::~HeapBatch()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stop = true;
+	}
+	m_cond.notify_all();
+	for (std::thread &thread : m_workers)
+		thread.join();
+}
+
+/* Take requests until none are left, or one failed in all-or-nothing mode */
+inline void HeapBatch::run()
+{
+	for (;;) {
+		if (m_mode == BATCH_ALL_OR_NOTHING && m_failed)
+			break;
+		size_t i = m_next++;
+		if (i >= m_requests->size())
+			break;
+
+		const struct Request &request = (*m_requests)[i];
+		struct Result &result = (*m_results)[i];
+		int fd = -1;
+		result.error = m_alloc(request.heap_fd, request.len, request.flags, &fd);
+		result.fd = result.error ? -1 : fd;
+		if (result.error)
+			m_failed = true;
+	}
+}
+
+inline void HeapBatch::worker()
+{
+	unsigned long seen = 0;
+
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_cond.wait(lock, [&] { return m_stop || m_generation != seen; });
+			if (m_stop)
+				return;
+			seen = m_generation;
+		}
+
+		run();
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (--m_busy == 0)
+			m_doneCond.notify_all();
+	}
+}
+
+inline int HeapBatch::allocate(const std::vector<struct Request> &requests, enum Mode mode,
+			       std::vector<struct Result> *results)
+{
+	std::lock_guard<std::mutex> batch(m_batchLock);
+
+	results->assign(requests.size(), Result{ -1, -ECANCELED });
+	if (requests.empty())
+		return 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_requests = &requests;
+		m_results = results;
+		m_mode = mode;
+		m_next = 0;
+		m_failed = false;
+		m_busy = m_workers.size();
+		m_generation++;
+	}
+	m_cond.notify_all();
+
+	run();
+
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_doneCond.wait(lock, [&] { return m_busy == 0; });
+	}
+
+	int ret = 0;
+	for (const struct Result &result : *results) {
+		if (result.error && result.error != -ECANCELED) {
+			ret = result.error;
+			break;
+		}
+	}
+
+	if (ret && mode == BATCH_ALL_OR_NOTHING) {
+		for (struct Result &result : *results) {
+			if (result.fd >= 0)
+				close(result.fd);
+			result.fd = -1;
+			if (!result.error)
+				result.error = -ECANCELED;
+		}
+	}
+
+	return ret;
+}
+
+inline void HeapBatch::release(std::vector<struct Result> *results)
+{
+	for (struct Result &result : *results) {
+		if (result.fd >= 0)
+			close(result.fd);
+		result.fd = -1;
+	}
+}
+
+#endif /* HEAP_BATCH_H_ */
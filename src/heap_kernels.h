@@ -0,0 +1,547 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HEAP_KERNELS_H_
+#define HEAP_KERNELS_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEAP_KERNELS_X86
+#elif defined(__aarch64__)
+#define HEAP_KERNELS_ARM64
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HEAP_KERNELS_NEON
+#endif
+
+__BEGIN_DECLS
+
+/*
+ * Bulk memory kernels for CPU access to heap buffers. Heaps that hand out
+ * uncached or write-combined mappings make ordinary cached stores and
+ * especially loads very slow, the non-temporal variants here write whole
+ * lines without a read-for-ownership and read through a small cached
+ * bounce buffer with streaming loads.
+ *
+ *   fill: like memset(), dst is the heap mapping
+ *   copy: like memcpy(), dst is the heap mapping
+ *   read: like memcpy(), src is the heap mapping
+ */
+struct heap_kernels {
+	const char *name;
+	void (*fill)(void *dst, int c, size_t len);
+	void (*copy)(void *dst, const void *src, size_t len);
+	void (*read)(void *dst, const void *src, size_t len);
+};
+
+enum heap_mapping_type {
+	HEAP_MAPPING_CACHED,
+	HEAP_MAPPING_UNCACHED,
+};
+
+#define HEAP_KERNELS_BOUNCE_SIZE 4096
+
+static inline void heap_fill_generic(void *dst, int c, size_t len)
+{
+	memset(dst, c, len);
+}
+
+static inline void heap_copy_generic(void *dst, const void *src, size_t len)
+{
+	memcpy(dst, src, len);
+}
+
+static const struct heap_kernels heap_kernels_generic = {
+	"generic", heap_fill_generic, heap_copy_generic, heap_copy_generic,
+};
+
+#ifdef HEAP_KERNELS_X86
+__attribute__((target("sse2")))
+static inline void heap_fill_sse2(void *dst, int c, size_t len)
+{
+	uint8_t *d = (uint8_t *)dst;
+	size_t head = -(uintptr_t)d & 15;
+	__m128i v = _mm_set1_epi8(c);
+
+	if (head > len)
+		head = len;
+	memset(d, c, head);
+	d += head;
+	len -= head;
+
+	for (; len >= 64; d += 64, len -= 64) {
+		_mm_stream_si128((__m128i *)d + 0, v);
+		_mm_stream_si128((__m128i *)d + 1, v);
+		_mm_stream_si128((__m128i *)d + 2, v);
+		_mm_stream_si128((__m128i *)d + 3, v);
+	}
+	for (; len >= 16; d += 16, len -= 16)
+		_mm_stream_si128((__m128i *)d, v);
+	_mm_sfence();
+
+	memset(d, c, len);
+}
+
+__attribute__((target("sse2")))
+static inline void heap_copy_sse2(void *dst, const void *src, size_t len)
+{
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+	size_t head = -(uintptr_t)d & 15;
+
+	if (head > len)
+		head = len;
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	len -= head;
+
+	for (; len >= 64; d += 64, s += 64, len -= 64) {
+		__m128i a = _mm_loadu_si128((const __m128i *)s + 0);
+		__m128i b = _mm_loadu_si128((const __m128i *)s + 1);
+		__m128i e = _mm_loadu_si128((const __m128i *)s + 2);
+		__m128i f = _mm_loadu_si128((const __m128i *)s + 3);
+		_mm_stream_si128((__m128i *)d + 0, a);
+		_mm_stream_si128((__m128i *)d + 1, b);
+		_mm_stream_si128((__m128i *)d + 2, e);
+		_mm_stream_si128((__m128i *)d + 3, f);
+	}
+	for (; len >= 16; d += 16, s += 16, len -= 16)
+		_mm_stream_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+	_mm_sfence();
+
+	memcpy(d, s, len);
+}
+
+/*
+ * MOVNTDQA only streams from write-combined memory, pull each block into
+ * a cache resident bounce buffer first and copy out from there.
+ */
+__attribute__((target("sse4.1")))
+static inline void heap_read_sse41(void *dst, const void *src, size_t len)
+{
+	__m128i bounce[HEAP_KERNELS_BOUNCE_SIZE / 16];
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+	size_t head = -(uintptr_t)s & 15;
+
+	if (head > len)
+		head = len;
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	len -= head;
+
+	while (len >= 16) {
+		size_t block = len < sizeof(bounce) ? len & ~(size_t)15 : sizeof(bounce);
+		size_t i;
+
+		for (i = 0; i < block / 16; i++)
+			bounce[i] = _mm_stream_load_si128((__m128i *)s + i);
+		memcpy(d, bounce, block);
+
+		d += block;
+		s += block;
+		len -= block;
+	}
+
+	memcpy(d, s, len);
+}
+
+__attribute__((target("avx2")))
+static inline void heap_fill_avx2(void *dst, int c, size_t len)
+{
+	uint8_t *d = (uint8_t *)dst;
+	size_t head = -(uintptr_t)d & 31;
+	__m256i v = _mm256_set1_epi8(c);
+
+	if (head > len)
+		head = len;
+	memset(d, c, head);
+	d += head;
+	len -= head;
+
+	for (; len >= 128; d += 128, len -= 128) {
+		_mm256_stream_si256((__m256i *)d + 0, v);
+		_mm256_stream_si256((__m256i *)d + 1, v);
+		_mm256_stream_si256((__m256i *)d + 2, v);
+		_mm256_stream_si256((__m256i *)d + 3, v);
+	}
+	for (; len >= 32; d += 32, len -= 32)
+		_mm256_stream_si256((__m256i *)d, v);
+	_mm_sfence();
+
+	memset(d, c, len);
+}
+
+__attribute__((target("avx2")))
+static inline void heap_copy_avx2(void *dst, const void *src, size_t len)
+{
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+	size_t head = -(uintptr_t)d & 31;
+
+	if (head > len)
+		head = len;
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	len -= head;
+
+	for (; len >= 128; d += 128, s += 128, len -= 128) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)s + 0);
+		__m256i b = _mm256_loadu_si256((const __m256i *)s + 1);
+		__m256i e = _mm256_loadu_si256((const __m256i *)s + 2);
+		__m256i f = _mm256_loadu_si256((const __m256i *)s + 3);
+		_mm256_stream_si256((__m256i *)d + 0, a);
+		_mm256_stream_si256((__m256i *)d + 1, b);
+		_mm256_stream_si256((__m256i *)d + 2, e);
+		_mm256_stream_si256((__m256i *)d + 3, f);
+	}
+	for (; len >= 32; d += 32, s += 32, len -= 32)
+		_mm256_stream_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+	_mm_sfence();
+
+	memcpy(d, s, len);
+}
+
+__attribute__((target("avx2")))
+static inline void heap_read_avx2(void *dst, const void *src, size_t len)
+{
+	__m256i bounce[HEAP_KERNELS_BOUNCE_SIZE / 32];
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+	size_t head = -(uintptr_t)s & 31;
+
+	if (head > len)
+		head = len;
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	len -= head;
+
+	while (len >= 32) {
+		size_t block = len < sizeof(bounce) ? len & ~(size_t)31 : sizeof(bounce);
+		size_t i;
+
+		for (i = 0; i < block / 32; i++)
+			bounce[i] = _mm256_stream_load_si256((__m256i *)s + i);
+		memcpy(d, bounce, block);
+
+		d += block;
+		s += block;
+		len -= block;
+	}
+
+	memcpy(d, s, len);
+}
+
+static const struct heap_kernels heap_kernels_sse = {
+	"sse", heap_fill_sse2, heap_copy_sse2, heap_read_sse41,
+};
+
+static const struct heap_kernels heap_kernels_avx2 = {
+	"avx2", heap_fill_avx2, heap_copy_avx2, heap_read_avx2,
+};
+#endif /* HEAP_KERNELS_X86 */
+
+#ifdef HEAP_KERNELS_ARM64
+/* STNP/LDNP are only a hint, but keep whole lines out of the caches */
+static inline void heap_fill_arm64(void *dst, int c, size_t len)
+{
+	uint8_t *d = (uint8_t *)dst;
+	size_t head = -(uintptr_t)d & 15;
+	uint64_t v = 0x0101010101010101ULL * (uint8_t)c;
+
+	if (head > len)
+		head = len;
+	memset(d, c, head);
+	d += head;
+	len -= head;
+
+	for (; len >= 64; d += 64, len -= 64)
+		__asm__ volatile(
+			"dup v0.2d, %1\n"
+			"stnp q0, q0, [%0]\n"
+			"stnp q0, q0, [%0, #32]\n"
+			: : "r" (d), "r" (v) : "v0", "memory");
+
+	memset(d, c, len);
+}
+
+static inline void heap_copy_arm64(void *dst, const void *src, size_t len)
+{
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+	size_t head = -(uintptr_t)d & 15;
+
+	if (head > len)
+		head = len;
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	len -= head;
+
+	for (; len >= 64; d += 64, s += 64, len -= 64)
+		__asm__ volatile(
+			"ldp q0, q1, [%1]\n"
+			"ldp q2, q3, [%1, #32]\n"
+			"stnp q0, q1, [%0]\n"
+			"stnp q2, q3, [%0, #32]\n"
+			: : "r" (d), "r" (s) : "v0", "v1", "v2", "v3", "memory");
+
+	memcpy(d, s, len);
+}
+
+static inline void heap_read_arm64(void *dst, const void *src, size_t len)
+{
+	uint8_t bounce[HEAP_KERNELS_BOUNCE_SIZE] __attribute__((aligned(64)));
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+
+	while (len >= 64) {
+		size_t block = len < sizeof(bounce) ? len & ~(size_t)63 : sizeof(bounce);
+		size_t i;
+
+		for (i = 0; i < block; i += 64) {
+			__builtin_prefetch(s + i + 512, 0, 0);
+			__asm__ volatile(
+				"ldnp q0, q1, [%1]\n"
+				"ldnp q2, q3, [%1, #32]\n"
+				"stp q0, q1, [%0]\n"
+				"stp q2, q3, [%0, #32]\n"
+				: : "r" (bounce + i), "r" (s + i) : "v0", "v1", "v2", "v3", "memory");
+		}
+		memcpy(d, bounce, block);
+
+		d += block;
+		s += block;
+		len -= block;
+	}
+
+	memcpy(d, s, len);
+}
+
+static const struct heap_kernels heap_kernels_arm64 = {
+	"arm64", heap_fill_arm64, heap_copy_arm64, heap_read_arm64,
+};
+#endif /* HEAP_KERNELS_ARM64 */
+
+#ifdef HEAP_KERNELS_NEON
+/* ARMv7 has no non-temporal stores, wide aligned bursts are the best we get */
+static inline void heap_fill_neon(void *dst, int c, size_t len)
+{
+	uint8_t *d = (uint8_t *)dst;
+	size_t head = -(uintptr_t)d & 15;
+	uint8x16_t v = vdupq_n_u8(c);
+
+	if (head > len)
+		head = len;
+	memset(d, c, head);
+	d += head;
+	len -= head;
+
+	for (; len >= 64; d += 64, len -= 64) {
+		vst1q_u8(d + 0, v);
+		vst1q_u8(d + 16, v);
+		vst1q_u8(d + 32, v);
+		vst1q_u8(d + 48, v);
+	}
+
+	memset(d, c, len);
+}
+
+static inline void heap_copy_neon(void *dst, const void *src, size_t len)
+{
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+	size_t head = -(uintptr_t)d & 15;
+
+	if (head > len)
+		head = len;
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	len -= head;
+
+	for (; len >= 64; d += 64, s += 64, len -= 64) {
+		uint8x16_t a = vld1q_u8(s + 0);
+		uint8x16_t b = vld1q_u8(s + 16);
+		uint8x16_t e = vld1q_u8(s + 32);
+		uint8x16_t f = vld1q_u8(s + 48);
+		vst1q_u8(d + 0, a);
+		vst1q_u8(d + 16, b);
+		vst1q_u8(d + 32, e);
+		vst1q_u8(d + 48, f);
+	}
+
+	memcpy(d, s, len);
+}
+
+static inline void heap_read_neon(void *dst, const void *src, size_t len)
+{
+	uint8_t bounce[HEAP_KERNELS_BOUNCE_SIZE] __attribute__((aligned(64)));
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+
+	while (len >= 64) {
+		size_t block = len < sizeof(bounce) ? len & ~(size_t)63 : sizeof(bounce);
+		size_t i;
+
+		for (i = 0; i < block; i += 64) {
+			__builtin_prefetch(s + i + 512, 0, 0);
+			vst1q_u8(bounce + i + 0, vld1q_u8(s + i + 0));
+			vst1q_u8(bounce + i + 16, vld1q_u8(s + i + 16));
+			vst1q_u8(bounce + i + 32, vld1q_u8(s + i + 32));
+			vst1q_u8(bounce + i + 48, vld1q_u8(s + i + 48));
+		}
+		memcpy(d, bounce, block);
+
+		d += block;
+		s += block;
+		len -= block;
+	}
+
+	memcpy(d, s, len);
+}
+
+static const struct heap_kernels heap_kernels_neon = {
+	"neon", heap_fill_neon, heap_copy_neon, heap_read_neon,
+};
+#endif /* HEAP_KERNELS_NEON */
+
+/*
+ * Get the idx'th kernel set this CPU can run, in order of preference
+ * starting at 0, or NULL past the last one. The generic set is always
+ * last.
+ */
+static inline const struct heap_kernels *heap_kernels_get(unsigned int idx)
+{
+	const struct heap_kernels *available[4];
+	unsigned int count = 0;
+
+#ifdef HEAP_KERNELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		available[count++] = &heap_kernels_avx2;
+	if (__builtin_cpu_supports("sse4.1"))
+		available[count++] = &heap_kernels_sse;
+#endif
+#ifdef HEAP_KERNELS_ARM64
+	available[count++] = &heap_kernels_arm64;
+#endif
+#ifdef HEAP_KERNELS_NEON
+	available[count++] = &heap_kernels_neon;
+#endif
+	available[count++] = &heap_kernels_generic;
+
+	return idx < count ? available[idx] : NULL;
+}
+
+static inline uint64_t heap_kernels_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+__attribute__((noinline, unused))
+static uint64_t heap_kernels_sum(const volatile uint64_t *ptr, size_t len)
+{
+	uint64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < len / sizeof(uint64_t); i++)
+		sum += ptr[i];
+
+	return sum;
+}
+
+#define HEAP_KERNELS_PROBE_SIZE (64 * 1024)
+
+/*
+ * Tell cached from uncached or write-combined mappings by timing a second
+ * read pass over (up to 64KiB of) the mapping against the same pass over
+ * ordinary heap memory. A cached mapping is served from the CPU caches on
+ * the second pass, anything else goes back to DRAM for every load.
+ * The mapping must be readable, its contents are not modified. On a
+ * DMA-BUF mapping call it inside a DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ
+ * bracket, like any other CPU read.
+ */
+static inline enum heap_mapping_type heap_kernels_probe(const void *ptr, size_t len)
+{
+	size_t probe = len < HEAP_KERNELS_PROBE_SIZE ? len : HEAP_KERNELS_PROBE_SIZE;
+	uint64_t ref_ns = UINT64_MAX;
+	uint64_t map_ns = UINT64_MAX;
+	volatile uint64_t sink = 0;
+	unsigned int i;
+
+	probe &= ~(size_t)(sizeof(uint64_t) - 1);
+	if (!probe)
+		return HEAP_MAPPING_CACHED;
+
+	uint64_t *ref = (uint64_t *)malloc(probe);
+	if (!ref)
+		return HEAP_MAPPING_CACHED;
+	memset(ref, 0, probe);
+
+	for (i = 0; i < 3; i++) {
+		uint64_t ns;
+
+		sink += heap_kernels_sum(ref, probe);
+		ns = heap_kernels_now_ns();
+		sink += heap_kernels_sum(ref, probe);
+		ns = heap_kernels_now_ns() - ns;
+		if (ns < ref_ns)
+			ref_ns = ns;
+
+		sink += heap_kernels_sum((const volatile uint64_t *)ptr, probe);
+		ns = heap_kernels_now_ns();
+		sink += heap_kernels_sum((const volatile uint64_t *)ptr, probe);
+		ns = heap_kernels_now_ns() - ns;
+		if (ns < map_ns)
+			map_ns = ns;
+	}
+	(void)sink;
+
+	free(ref);
+
+	return map_ns > ref_ns * 4 ? HEAP_MAPPING_UNCACHED : HEAP_MAPPING_CACHED;
+}
+
+/*
+ * Pick the kernels to use for a heap mapping. The C library routines are
+ * already the best choice for cached memory, everything else gets the
+ * preferred non-temporal set.
+ */
+static inline const struct heap_kernels *heap_kernels_select(const void *ptr, size_t len)
+{
+	if (heap_kernels_probe(ptr, len) == HEAP_MAPPING_CACHED)
+		return &heap_kernels_generic;
+
+	return heap_kernels_get(0);
+}
+
+__END_DECLS
+
+#endif /* HEAP_KERNELS_H_ */
@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HEAP_POLICY_H_
+#define HEAP_POLICY_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+
+#include "heap_helper.h"
+
+/*
+ * Allocation front end over several heaps. Each request declares what it
+ * needs and every heap that qualifies is tried in turn, preferred heaps
+ * first and then by expected cost from each heap's recent latency and
+ * failure rate.
+ *
+ * A heap that fails or takes longer than the request's latency budget is
+ * demoted: it is skipped for the next requests and only probed again
+ * with one real request after an exponentially growing number of them,
+ * or when nothing else can satisfy a request. Only one request at a time
+ * gets to probe, concurrent ones treat the heap as still demoted. A
+ * stalling heap (such as a fragmented CMA area) therefore costs at most
+ * one slow allocation per backoff period instead of one per request. A
+ * probe that comes back within budget restores the heap.
+ */
+class HeapPolicy {
+public:
+	enum {
+		HEAP_CONTIGUOUS = 1 << 0,
+		HEAP_CACHED = 1 << 1,
+	};
+
+	struct Constraints {
+		/* only heaps handing out physically contiguous buffers */
+		bool contiguous;
+		/* try cached heaps before uncached ones */
+		bool cached;
+		/* allocations taking longer demote the heap, 0 for no budget */
+		uint64_t latency_budget_ns;
+	};
+
+	struct HeapStats {
+		std::string name;
+		unsigned int flags;
+		unsigned long allocs;
+		unsigned long failures;
+		unsigned long budget_misses;
+		unsigned long probes;
+		double latency_ns;
+		double failure_rate;
+		bool demoted;
+	};
+
+	/* Same contract as heap_alloc(), used to inject faults and latency */
+	typedef std::function<int(int heap_fd, size_t len, int *dmabuf_fd)> AllocFn;
+
+	/* Weight of the newest sample in the latency and failure averages */
+	static constexpr double ewmaWeight = 1.0 / 8;
+	/* Requests a demoted heap sits out, doubled on every failed probe */
+	static const unsigned int minBackoff = 16;
+	static const unsigned int maxBackoff = 1024;
+
+	explicit HeapPolicy(AllocFn alloc = AllocFn());
+
+	HeapPolicy(const HeapPolicy &) = delete;
+	HeapPolicy &operator=(const HeapPolicy &) = delete;
+
+	/*
+	 * Heaps are tried in the order added when nothing else tells them
+	 * apart. The fd stays owned by the caller. Returns the heap index.
+	 */
+	int add_heap(const std::string &name, int fd, unsigned int flags);
+	int add_heap(const std::string &name, int fd);
+
+	/* Heap properties from the usual heap names, e.g. "reserved" or "system-uncached" */
+	static unsigned int guess_flags(const std::string &name);
+
+	/*
+	 * Returns 0 and the DMA-BUF fd, with the index of the heap that
+	 * served it in heap if not NULL. Returns -ENODEV if no heap meets
+	 * the constraints, otherwise the error of the last heap tried.
+	 */
+	int allocate(size_t len, const struct Constraints &constraints, int *dmabuf_fd,
+		     int *heap = nullptr);
+
+	std::vector<struct HeapStats> stats();
+
+private:
+	struct HeapState {
+		std::string name;
+		int fd;
+		unsigned int flags;
+		unsigned long allocs;
+		unsigned long failures;
+		unsigned long budget_misses;
+		unsigned long probes;
+		bool sampled;
+		double latency_ns;
+		double failure_rate;
+		bool demoted;
+		/* a request is trying it off backoff right now */
+		bool probing;
+		unsigned int backoff;
+		unsigned int skip;
+	};
+
+	std::vector<int> candidates(const struct Constraints &constraints, std::vector<int> *demoted);
+	void record(int idx, int ret, uint64_t ns, const struct Constraints &constraints, bool probe);
+
+	AllocFn m_alloc;
+	std::mutex m_lock;
+	std::vector<struct HeapState> m_heaps;
+};
+
+inline HeapPolicy::HeapPolicy(AllocFn alloc) :
+	m_alloc(alloc)
+{
+	if (!m_alloc)
+		m_alloc = [](int heap_fd, size_t len, int *dmabuf_fd) {
+			return heap_alloc(heap_fd, len, 0, dmabuf_fd);
+		};
+}
+
+inline int HeapPolicy::add_heap(const std::string &name, int fd, unsigned int flags)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	struct HeapState heap = HeapState();
+
+	heap.name = name;
+	heap.fd = fd;
+	heap.flags = flags;
+	heap.backoff = minBackoff;
+	m_heaps.push_back(heap);
+
+	return m_heaps.size() - 1;
+}
+
+inline int HeapPolicy::add_heap(const std::string &name, int fd)
+{
+	return add_heap(name, fd, guess_flags(name));
+}
+
+inline unsigned int HeapPolicy::guess_flags(const std::string &name)
+{
+	static const char *contiguous[] = { "cma", "reserved", "carveout", "contig" };
+	unsigned int flags = HEAP_CACHED;
+
+	for (const char *hint : contiguous)
+		if (name.find(hint) != std::string::npos)
+			flags |= HEAP_CONTIGUOUS;
+	if (name.find("uncached") != std::string::npos)
+		flags &= ~HEAP_CACHED;
+
+	return flags;
+}
+
+/*
+ * Heaps to try for a request in order, a demoted heap due for its probe
+ * goes first. Demoted heaps that are not due go to demoted instead, as a
+ * last resort.
+ */
+inline std::vector<int> HeapPolicy::candidates(const struct Constraints &constraints,
+					       std::vector<int> *demoted)
+{
+	std::vector<int> order;
+
+	for (size_t i = 0; i < m_heaps.size(); i++) {
+		struct HeapState &heap = m_heaps[i];
+		if (constraints.contiguous && !(heap.flags & HEAP_CONTIGUOUS))
+			continue;
+		if (heap.demoted && (heap.skip || heap.probing)) {
+			if (heap.skip)
+				heap.skip--;
+			demoted->push_back(i);
+			continue;
+		}
+		order.push_back(i);
+	}
+
+	/* expected time to a successful allocation */
+	auto cost = [this](int idx) {
+		const struct HeapState &heap = m_heaps[idx];
+		return heap.latency_ns / std::max(1.0 - heap.failure_rate, 0.01);
+	};
+	auto better = [&](int a, int b) {
+		if (constraints.cached) {
+			bool cached_a = m_heaps[a].flags & HEAP_CACHED;
+			bool cached_b = m_heaps[b].flags & HEAP_CACHED;
+			if (cached_a != cached_b)
+				return cached_a;
+		}
+		/* its averages only recover if a heap off backoff is really tried */
+		if (m_heaps[a].demoted != m_heaps[b].demoted)
+			return m_heaps[a].demoted;
+		return cost(a) < cost(b);
+	};
+	std::stable_sort(order.begin(), order.end(), better);
+	std::stable_sort(demoted->begin(), demoted->end(), better);
+
+	return order;
+}
+
+inline void HeapPolicy::record(int idx, int ret, uint64_t ns,
+			       const struct Constraints &constraints, bool probe)
+{
+	struct HeapState &heap = m_heaps[idx];
+	bool miss = constraints.latency_budget_ns && ns > constraints.latency_budget_ns;
+
+	heap.allocs++;
+	if (ret)
+		heap.failures++;
+	if (miss)
+		heap.budget_misses++;
+	if (probe)
+		heap.probes++;
+
+	if (!heap.sampled) {
+		heap.latency_ns = ns;
+		heap.failure_rate = ret ? 1.0 : 0.0;
+		heap.sampled = true;
+	} else {
+		heap.latency_ns += (ns - heap.latency_ns) * ewmaWeight;
+		heap.failure_rate += ((ret ? 1.0 : 0.0) - heap.failure_rate) * ewmaWeight;
+	}
+
+	if (ret || miss) {
+		if (heap.demoted && heap.backoff < maxBackoff)
+			heap.backoff *= 2;
+		heap.demoted = true;
+		heap.skip = heap.backoff;
+	} else if (heap.demoted) {
+		/* back in service, start over from this sample */
+		heap.demoted = false;
+		heap.latency_ns = ns;
+		heap.backoff = minBackoff;
+		heap.skip = 0;
+	}
+}
+
+inline int HeapPolicy::allocate(size_t len, const struct Constraints &constraints,
+				int *dmabuf_fd, int *heap)
+{
+	std::vector<int> order, demoted, fds;
+	std::vector<bool> probing, claimed;
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		order = candidates(constraints, &demoted);
+		/* the probes off backoff are ours alone until they are recorded */
+		for (int idx : order) {
+			claimed.push_back(m_heaps[idx].demoted);
+			if (m_heaps[idx].demoted)
+				m_heaps[idx].probing = true;
+		}
+		claimed.resize(order.size() + demoted.size(), false);
+		order.insert(order.end(), demoted.begin(), demoted.end());
+		/* any try of a demoted heap is a probe, off backoff or as last resort */
+		for (int idx : order) {
+			fds.push_back(m_heaps[idx].fd);
+			probing.push_back(m_heaps[idx].demoted);
+		}
+	}
+	if (order.empty())
+		return -ENODEV;
+
+	int ret = -ENOMEM;
+	size_t i;
+	for (i = 0; i < order.size(); i++) {
+		auto start = std::chrono::steady_clock::now();
+		ret = m_alloc(fds[i], len, dmabuf_fd);
+		uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start).count();
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			record(order[i], ret, ns, constraints, probing[i]);
+			if (claimed[i])
+				m_heaps[order[i]].probing = false;
+		}
+		if (!ret)
+			break;
+	}
+
+	/* a preferred heap served the request before a claimed probe was tried */
+	if (i + 1 < order.size() && std::find(claimed.begin() + i + 1, claimed.end(), true) != claimed.end()) {
+		std::lock_guard<std::mutex> lock(m_lock);
+		for (size_t j = i + 1; j < order.size(); j++)
+			if (claimed[j])
+				m_heaps[order[j]].probing = false;
+	}
+
+	if (!ret && heap)
+		*heap = order[i];
+
+	return ret;
+}
+
+inline std::vector<struct HeapPolicy::HeapStats> HeapPolicy::stats()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	std::vector<struct HeapStats> stats;
+
+	for (const struct HeapState &heap : m_heaps) {
+		struct HeapStats s;
+		s.name = heap.name;
+		s.flags = heap.flags;
+		s.allocs = heap.allocs;
+		s.failures = heap.failures;
+		s.budget_misses = heap.budget_misses;
+		s.probes = heap.probes;
+		s.latency_ns = heap.latency_ns;
+		s.failure_rate = heap.failure_rate;
+		s.demoted = heap.demoted;
+		stats.push_back(s);
+	}
+
+	return stats;
+}
+
+#endif /* HEAP_POLICY_H_ */
@@ -0,0 +1,492 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HEAP_STREAM_H_
+#define HEAP_STREAM_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * Streaming access to a DMA-BUF through a bounded set of fixed-size mapped
+ * windows. Only max_windows * window_size bytes of address space are ever
+ * in use, so buffers larger than what the process can map whole can still
+ * be walked from start to end. Windows are recycled least-recently-used
+ * first and, when enabled, the window after the one being accessed is
+ * mapped and populated ahead of time on a helper thread.
+ */
+class HeapStream {
+public:
+	struct Chunk {
+		uint64_t offset;
+		uint8_t *ptr;
+		size_t len;
+	};
+
+	struct Stats {
+		unsigned long maps;
+		unsigned long hits;
+		unsigned long prefetched;
+	};
+
+	template <bool Writable>
+	class Iterator;
+	template <bool Writable>
+	class Range;
+
+	typedef Iterator<false> ReadIterator;
+	typedef Iterator<true> WriteIterator;
+
+	HeapStream();
+	~HeapStream();
+
+	HeapStream(const HeapStream &) = delete;
+	HeapStream &operator=(const HeapStream &) = delete;
+
+	/*
+	 * window_size must be a multiple of the page size and max_windows at
+	 * least 2 so one window can be in use while the next is prefetched.
+	 * Returns 0 or a negative errno.
+	 */
+	int open(int fd, uint64_t size, size_t window_size, unsigned int max_windows,
+		 int prot = PROT_READ | PROT_WRITE, bool prefetch = true);
+	void close();
+
+	/*
+	 * Pin the window holding offset and return the mapped bytes from
+	 * offset to the end of that window. Every successful acquire() must be
+	 * paired with a release() of the same chunk and no more than
+	 * max_windows - 1 chunks may be held at once.
+	 */
+	int acquire(uint64_t offset, struct Chunk *chunk);
+	void release(const struct Chunk &chunk);
+
+	/* Ask the helper thread to map the window holding offset */
+	void prefetch(uint64_t offset);
+
+	Range<false> read(uint64_t offset, uint64_t len);
+	Range<true> write(uint64_t offset, uint64_t len);
+	Range<false> read();
+	Range<true> write();
+
+	uint64_t size() const { return m_size; }
+	size_t window_size() const { return m_windowSize; }
+	struct Stats stats();
+
+	/*
+	 * First error an acquire() failed with since open(), sticky so a
+	 * range loop that stopped early can be told from one that finished.
+	 */
+	int error();
+
+private:
+	enum SlotState { SLOT_EMPTY, SLOT_LOADING, SLOT_READY };
+
+	struct Slot {
+		enum SlotState state;
+		uint64_t window;
+		uint8_t *ptr;
+		size_t len;
+		unsigned int pins;
+		unsigned long last_use;
+		bool prefetched;
+	};
+
+	int find_slot(uint64_t window);
+	int load(std::unique_lock<std::mutex> &lock, uint64_t window, bool pin, bool wait);
+	void prefetch_worker();
+
+	int m_fd;
+	uint64_t m_size;
+	size_t m_windowSize;
+	int m_prot;
+	unsigned long m_tick;
+	struct Stats m_stats;
+	int m_error;
+	std::vector<struct Slot> m_slots;
+
+	std::mutex m_lock;
+	std::condition_variable m_cond;
+	std::thread m_prefetchThread;
+	bool m_prefetchEnabled;
+	bool m_prefetchPending;
+	uint64_t m_prefetchWindow;
+	bool m_stop;
+};
+
+/*
+ * Walks [offset, offset + len) one window at a time, yielding a Chunk per
+ * window. The current window stays pinned for as long as the iterator
+ * points at it and the following window is prefetched when it is entered.
+ */
+template <bool Writable>
+class HeapStream::Iterator {
+public:
+	typedef typename std::conditional<Writable, uint8_t, const uint8_t>::type byte_type;
+
+	Iterator() : m_stream(nullptr), m_pos(0), m_end(0), m_chunk(), m_error(0) {}
+	Iterator(HeapStream *stream, uint64_t pos, uint64_t end) :
+		m_stream(stream), m_pos(pos), m_end(end), m_chunk(), m_error(0)
+	{
+		enter();
+	}
+	~Iterator() { leave(); }
+
+	Iterator(const Iterator &) = delete;
+	Iterator &operator=(const Iterator &) = delete;
+	Iterator(Iterator &&other) :
+		m_stream(other.m_stream), m_pos(other.m_pos), m_end(other.m_end),
+		m_chunk(other.m_chunk), m_error(other.m_error)
+	{
+		other.m_chunk.ptr = nullptr;
+		other.m_pos = other.m_end;
+	}
+
+	uint64_t offset() const { return m_chunk.offset; }
+	byte_type *data() const { return m_chunk.ptr; }
+	size_t size() const { return m_chunk.len; }
+	/*
+	 * Non-zero if mapping a window failed, iteration stops early. Also
+	 * kept by HeapStream::error() after the iterator is gone.
+	 */
+	int error() const { return m_error; }
+
+	const Iterator &operator*() const { return *this; }
+
+	Iterator &operator++()
+	{
+		m_pos += m_chunk.len;
+		leave();
+		enter();
+		return *this;
+	}
+
+	bool operator!=(const Iterator &other) const
+	{
+		return m_pos != other.m_pos;
+	}
+
+private:
+	void enter()
+	{
+		if (!m_stream || m_pos >= m_end)
+			return;
+
+		int ret = m_stream->acquire(m_pos, &m_chunk);
+		if (ret) {
+			m_error = ret;
+			m_pos = m_end;
+			m_chunk.ptr = nullptr;
+			return;
+		}
+		if (m_chunk.len > m_end - m_pos)
+			m_chunk.len = m_end - m_pos;
+
+		uint64_t next = m_pos - m_pos % m_stream->window_size() + m_stream->window_size();
+		if (next < m_end)
+			m_stream->prefetch(next);
+	}
+
+	void leave()
+	{
+		if (m_stream && m_chunk.ptr)
+			m_stream->release(m_chunk);
+		m_chunk.ptr = nullptr;
+	}
+
+	HeapStream *m_stream;
+	uint64_t m_pos;
+	uint64_t m_end;
+	struct Chunk m_chunk;
+	int m_error;
+};
+
+template <bool Writable>
+class HeapStream::Range {
+public:
+	Range(HeapStream *stream, uint64_t begin, uint64_t end) :
+		m_stream(stream), m_begin(begin), m_end(end) {}
+
+	Iterator<Writable> begin() const { return Iterator<Writable>(m_stream, m_begin, m_end); }
+	Iterator<Writable> end() const { return Iterator<Writable>(nullptr, m_end, m_end); }
+
+private:
+	HeapStream *m_stream;
+	uint64_t m_begin;
+	uint64_t m_end;
+};
+
+inline HeapStream::HeapStream() :
+	m_fd(-1), m_size(0), m_windowSize(0), m_prot(0), m_tick(0),
+	m_stats(), m_error(0), m_slots(), m_prefetchEnabled(false), m_prefetchPending(false),
+	m_prefetchWindow(0), m_stop(false)
+{
+}
+
+inline HeapStream::~HeapStream()
+{
+	close();
+}
+
+inline int HeapStream::open(int fd, uint64_t size, size_t window_size,
+			    unsigned int max_windows, int prot, bool prefetch)
+{
+	unsigned long psize = sysconf(_SC_PAGESIZE);
+
+	if (m_fd >= 0)
+		return -EBUSY;
+	if (fd < 0 || size == 0)
+		return -EINVAL;
+	if (window_size == 0 || window_size % psize)
+		return -EINVAL;
+	if (max_windows < 2)
+		return -EINVAL;
+
+	m_fd = fd;
+	m_size = size;
+	m_windowSize = window_size;
+	m_prot = prot;
+	m_tick = 0;
+	m_stats = Stats();
+	m_error = 0;
+	m_slots.assign(max_windows, Slot());
+	for (struct Slot &slot : m_slots)
+		slot.state = SLOT_EMPTY;
+
+	m_stop = false;
+	m_prefetchPending = false;
+	m_prefetchEnabled = prefetch;
+	if (prefetch)
+		m_prefetchThread = std::thread(&HeapStream::prefetch_worker, this);
+
+	return 0;
+}
+
+inline void HeapStream::close()
+{
+	if (m_fd < 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_stop = true;
+	}
+	m_cond.notify_all();
+	if (m_prefetchThread.joinable())
+		m_prefetchThread.join();
+
+	for (struct Slot &slot : m_slots) {
+		if (slot.state == SLOT_READY)
+			munmap(slot.ptr, slot.len);
+		slot.state = SLOT_EMPTY;
+	}
+	m_slots.clear();
+	m_fd = -1;
+}
+
+inline int HeapStream::find_slot(uint64_t window)
+{
+	for (size_t i = 0; i < m_slots.size(); i++)
+		if (m_slots[i].state != SLOT_EMPTY && m_slots[i].window == window)
+			return i;
+	return -1;
+}
+
+/*
+ * Called and returns with the lock held, drops it around mmap()/munmap().
+ * When wait is false give up with -EBUSY instead of sleeping for a slot.
+ */
+inline int HeapStream::load(std::unique_lock<std::mutex> &lock, uint64_t window,
+			    bool pin, bool wait)
+{
+	for (;;) {
+		int i = find_slot(window);
+		if (i >= 0) {
+			struct Slot &slot = m_slots[i];
+			if (slot.state == SLOT_LOADING) {
+				if (!wait)
+					return 0;
+				m_cond.wait(lock);
+				continue;
+			}
+			if (pin) {
+				slot.pins++;
+				slot.last_use = ++m_tick;
+				m_stats.hits++;
+				if (slot.prefetched)
+					m_stats.prefetched++;
+				slot.prefetched = false;
+			}
+			return 0;
+		}
+
+		/* Pick an empty slot, otherwise the least recently used idle one */
+		int victim = -1;
+		for (size_t j = 0; j < m_slots.size(); j++) {
+			struct Slot &slot = m_slots[j];
+			if (slot.state == SLOT_EMPTY) {
+				victim = j;
+				break;
+			}
+			if (slot.state == SLOT_READY && !slot.pins &&
+			    (victim < 0 || slot.last_use < m_slots[victim].last_use))
+				victim = j;
+		}
+		if (victim < 0) {
+			if (!wait)
+				return -EBUSY;
+			m_cond.wait(lock);
+			continue;
+		}
+
+		struct Slot &slot = m_slots[victim];
+		uint8_t *old_ptr = slot.state == SLOT_READY ? slot.ptr : nullptr;
+		size_t old_len = slot.len;
+		uint64_t offset = window * m_windowSize;
+		size_t len = m_size - offset < m_windowSize ? m_size - offset : m_windowSize;
+
+		slot.state = SLOT_LOADING;
+		slot.window = window;
+		slot.pins = pin ? 1 : 0;
+		slot.prefetched = !pin;
+
+		lock.unlock();
+		if (old_ptr)
+			munmap(old_ptr, old_len);
+		void *ptr = mmap(NULL, len, m_prot, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+		int ret = ptr == MAP_FAILED ? -errno : 0;
+		lock.lock();
+
+		if (ret) {
+			slot.state = SLOT_EMPTY;
+			slot.pins = 0;
+		} else {
+			slot.state = SLOT_READY;
+			slot.ptr = (uint8_t *)ptr;
+			slot.len = len;
+			slot.last_use = ++m_tick;
+			m_stats.maps++;
+		}
+		m_cond.notify_all();
+
+		return ret;
+	}
+}
+
+inline int HeapStream::acquire(uint64_t offset, struct Chunk *chunk)
+{
+	if (m_fd < 0 || offset >= m_size)
+		return -EINVAL;
+
+	uint64_t window = offset / m_windowSize;
+
+	std::unique_lock<std::mutex> lock(m_lock);
+	int ret = load(lock, window, true, true);
+	if (ret) {
+		if (!m_error)
+			m_error = ret;
+		return ret;
+	}
+
+	struct Slot &slot = m_slots[find_slot(window)];
+	size_t skip = offset - window * m_windowSize;
+	chunk->offset = offset;
+	chunk->ptr = slot.ptr + skip;
+	chunk->len = slot.len - skip;
+
+	return 0;
+}
+
+inline void HeapStream::release(const struct Chunk &chunk)
+{
+	uint64_t window = chunk.offset / m_windowSize;
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	int i = find_slot(window);
+	if (i >= 0 && m_slots[i].pins)
+		m_slots[i].pins--;
+	m_cond.notify_all();
+}
+
+inline void HeapStream::prefetch(uint64_t offset)
+{
+	if (!m_prefetchEnabled || offset >= m_size)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_prefetchWindow = offset / m_windowSize;
+		m_prefetchPending = true;
+	}
+	m_cond.notify_all();
+}
+
+inline void HeapStream::prefetch_worker()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	for (;;) {
+		m_cond.wait(lock, [this] { return m_stop || m_prefetchPending; });
+		if (m_stop)
+			break;
+		m_prefetchPending = false;
+		/* Never sleep here, a busy cache just means no prefetch */
+		load(lock, m_prefetchWindow, false, false);
+	}
+}
+
+inline HeapStream::Range<false> HeapStream::read(uint64_t offset, uint64_t len)
+{
+	uint64_t end = offset + len > m_size ? m_size : offset + len;
+	return Range<false>(this, offset, end);
+}
+
+inline HeapStream::Range<true> HeapStream::write(uint64_t offset, uint64_t len)
+{
+	uint64_t end = offset + len > m_size ? m_size : offset + len;
+	return Range<true>(this, offset, end);
+}
+
+inline HeapStream::Range<false> HeapStream::read()
+{
+	return read(0, m_size);
+}
+
+inline HeapStream::Range<true> HeapStream::write()
+{
+	return write(0, m_size);
+}
+
+inline struct HeapStream::Stats HeapStream::stats()
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	return m_stats;
+}
+
+inline int HeapStream::error()
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	return m_error;
+}
+
+#endif /* HEAP_STREAM_H_ */
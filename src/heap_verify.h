@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HEAP_VERIFY_H_
+#define HEAP_VERIFY_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "heap_kernels.h"
+
+#if defined(HEAP_KERNELS_ARM64) || defined(HEAP_KERNELS_NEON)
+#include <arm_neon.h>
+#endif
+
+__BEGIN_DECLS
+
+/*
+ * Buffer content checks that compare against a generated value instead of
+ * a second buffer. Large buffers are split across one thread per CPU.
+ *
+ * The pattern is a sequence of native endian 64-bit words where word k
+ * holds (seed + k) * HEAP_PATTERN_MULT. A sub-range starting at byte
+ * offset o (a multiple of 8) of a pattern written with seed s can be
+ * checked on its own with seed s + o / 8.
+ */
+#define HEAP_PATTERN_MULT 0x9e3779b97f4a7c15ULL
+
+/* Scan len bytes, return the offset of the first mismatch or len */
+typedef size_t (*heap_scan_fn)(const uint8_t *ptr, size_t len, uint64_t arg);
+
+static inline size_t heap_scan_fill_generic(const uint8_t *ptr, size_t len, uint64_t c)
+{
+	uint64_t expect = 0x0101010101010101ULL * (uint8_t)c;
+	size_t i = 0;
+
+	for (; i + 8 <= len; i += 8) {
+		uint64_t word;
+		memcpy(&word, ptr + i, 8);
+		if (word != expect)
+			break;
+	}
+	for (; i < len; i++)
+		if (ptr[i] != (uint8_t)c)
+			return i;
+
+	return len;
+}
+
+static inline size_t heap_scan_pattern_generic(const uint8_t *ptr, size_t len, uint64_t seed)
+{
+	uint64_t expect = seed * HEAP_PATTERN_MULT;
+	uint8_t bytes[8];
+	size_t i = 0;
+
+	for (; i + 8 <= len; i += 8, expect += HEAP_PATTERN_MULT) {
+		uint64_t word;
+		memcpy(&word, ptr + i, 8);
+		if (word != expect)
+			break;
+	}
+	memcpy(bytes, &expect, 8);
+	for (; i < len; i++)
+		if (ptr[i] != bytes[i % 8])
+			return i;
+
+	return len;
+}
+
+/*
+ * The vector scanners only find the 128 byte block holding the mismatch
+ * and leave pinpointing it to the generic scanners.
+ */
+#ifdef HEAP_KERNELS_X86
+__attribute__((target("sse2")))
+static inline size_t heap_scan_fill_sse2(const uint8_t *ptr, size_t len, uint64_t c)
+{
+	__m128i v = _mm_set1_epi8((char)c);
+	__m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i + 128 <= len; i += 128) {
+		const __m128i *p = (const __m128i *)(ptr + i);
+		__m128i x = _mm_or_si128(
+			_mm_or_si128(
+				_mm_or_si128(_mm_xor_si128(_mm_loadu_si128(p + 0), v),
+					     _mm_xor_si128(_mm_loadu_si128(p + 1), v)),
+				_mm_or_si128(_mm_xor_si128(_mm_loadu_si128(p + 2), v),
+					     _mm_xor_si128(_mm_loadu_si128(p + 3), v))),
+			_mm_or_si128(
+				_mm_or_si128(_mm_xor_si128(_mm_loadu_si128(p + 4), v),
+					     _mm_xor_si128(_mm_loadu_si128(p + 5), v)),
+				_mm_or_si128(_mm_xor_si128(_mm_loadu_si128(p + 6), v),
+					     _mm_xor_si128(_mm_loadu_si128(p + 7), v))));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero)) != 0xffff)
+			break;
+	}
+
+	return i + heap_scan_fill_generic(ptr + i, len - i, c);
+}
+
+__attribute__((target("sse2")))
+static inline size_t heap_scan_pattern_sse2(const uint8_t *ptr, size_t len, uint64_t seed)
+{
+	__m128i e = _mm_set_epi64x((seed + 1) * HEAP_PATTERN_MULT, seed * HEAP_PATTERN_MULT);
+	__m128i step = _mm_set1_epi64x(2 * HEAP_PATTERN_MULT);
+	__m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i + 128 <= len; i += 128) {
+		const __m128i *p = (const __m128i *)(ptr + i);
+		__m128i x = zero;
+		unsigned int j;
+
+		for (j = 0; j < 8; j++) {
+			x = _mm_or_si128(x, _mm_xor_si128(_mm_loadu_si128(p + j), e));
+			e = _mm_add_epi64(e, step);
+		}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero)) != 0xffff)
+			break;
+	}
+
+	return i + heap_scan_pattern_generic(ptr + i, len - i, seed + i / 8);
+}
+
+__attribute__((target("avx2")))
+static inline size_t heap_scan_fill_avx2(const uint8_t *ptr, size_t len, uint64_t c)
+{
+	__m256i v = _mm256_set1_epi8((char)c);
+	size_t i = 0;
+
+	for (; i + 128 <= len; i += 128) {
+		const __m256i *p = (const __m256i *)(ptr + i);
+		__m256i x = _mm256_or_si256(
+			_mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256(p + 0), v),
+					_mm256_xor_si256(_mm256_loadu_si256(p + 1), v)),
+			_mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256(p + 2), v),
+					_mm256_xor_si256(_mm256_loadu_si256(p + 3), v)));
+		if (!_mm256_testz_si256(x, x))
+			break;
+	}
+
+	return i + heap_scan_fill_generic(ptr + i, len - i, c);
+}
+
+__attribute__((target("avx2")))
+static inline size_t heap_scan_pattern_avx2(const uint8_t *ptr, size_t len, uint64_t seed)
+{
+	__m256i e = _mm256_set_epi64x((seed + 3) * HEAP_PATTERN_MULT,
+				      (seed + 2) * HEAP_PATTERN_MULT,
+				      (seed + 1) * HEAP_PATTERN_MULT,
+				      seed * HEAP_PATTERN_MULT);
+	__m256i step = _mm256_set1_epi64x(4 * HEAP_PATTERN_MULT);
+	size_t i = 0;
+
+	for (; i + 128 <= len; i += 128) {
+		const __m256i *p = (const __m256i *)(ptr + i);
+		__m256i e1 = _mm256_add_epi64(e, step);
+		__m256i e2 = _mm256_add_epi64(e1, step);
+		__m256i e3 = _mm256_add_epi64(e2, step);
+		__m256i x = _mm256_or_si256(
+			_mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256(p + 0), e),
+					_mm256_xor_si256(_mm256_loadu_si256(p + 1), e1)),
+			_mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256(p + 2), e2),
+					_mm256_xor_si256(_mm256_loadu_si256(p + 3), e3)));
+		if (!_mm256_testz_si256(x, x))
+			break;
+		e = _mm256_add_epi64(e3, step);
+	}
+
+	return i + heap_scan_pattern_generic(ptr + i, len - i, seed + i / 8);
+}
+#endif /* HEAP_KERNELS_X86 */
+
+#if defined(HEAP_KERNELS_ARM64) || defined(HEAP_KERNELS_NEON)
+static inline int heap_scan_nonzero_neon(uint8x16_t x)
+{
+	uint64x2_t w = vreinterpretq_u64_u8(x);
+
+	return (vgetq_lane_u64(w, 0) | vgetq_lane_u64(w, 1)) != 0;
+}
+
+static inline size_t heap_scan_fill_neon(const uint8_t *ptr, size_t len, uint64_t c)
+{
+	uint8x16_t v = vdupq_n_u8((uint8_t)c);
+	size_t i = 0;
+
+	for (; i + 128 <= len; i += 128) {
+		const uint8_t *p = ptr + i;
+		uint8x16_t x = vdupq_n_u8(0);
+		unsigned int j;
+
+		for (j = 0; j < 128; j += 16)
+			x = vorrq_u8(x, veorq_u8(vld1q_u8(p + j), v));
+		if (heap_scan_nonzero_neon(x))
+			break;
+	}
+
+	return i + heap_scan_fill_generic(ptr + i, len - i, c);
+}
+
+static inline size_t heap_scan_pattern_neon(const uint8_t *ptr, size_t len, uint64_t seed)
+{
+	uint64_t start[2] = { seed * HEAP_PATTERN_MULT, (seed + 1) * HEAP_PATTERN_MULT };
+	uint64x2_t e = vld1q_u64(start);
+	uint64x2_t step = vdupq_n_u64(2 * HEAP_PATTERN_MULT);
+	size_t i = 0;
+
+	for (; i + 128 <= len; i += 128) {
+		const uint8_t *p = ptr + i;
+		uint64x2_t x = vdupq_n_u64(0);
+		unsigned int j;
+
+		for (j = 0; j < 128; j += 16) {
+			x = vorrq_u64(x, veorq_u64(vreinterpretq_u64_u8(vld1q_u8(p + j)), e));
+			e = vaddq_u64(e, step);
+		}
+		if (heap_scan_nonzero_neon(vreinterpretq_u8_u64(x)))
+			break;
+	}
+
+	return i + heap_scan_pattern_generic(ptr + i, len - i, seed + i / 8);
+}
+#endif
+
+static inline void heap_verify_scanners(heap_scan_fn *fill, heap_scan_fn *pattern)
+{
+	*fill = heap_scan_fill_generic;
+	*pattern = heap_scan_pattern_generic;
+
+#ifdef HEAP_KERNELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		*fill = heap_scan_fill_avx2;
+		*pattern = heap_scan_pattern_avx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		*fill = heap_scan_fill_sse2;
+		*pattern = heap_scan_pattern_sse2;
+	}
+#endif
+#if defined(HEAP_KERNELS_ARM64) || defined(HEAP_KERNELS_NEON)
+	*fill = heap_scan_fill_neon;
+	*pattern = heap_scan_pattern_neon;
+#endif
+}
+
+/* Below this a buffer is not worth splitting across threads */
+#define HEAP_VERIFY_THREAD_MIN (8 * 1024 * 1024)
+/* How often workers look for an earlier mismatch found by another one */
+#define HEAP_VERIFY_BLOCK (1024 * 1024)
+#define HEAP_VERIFY_MAX_THREADS 32
+
+struct heap_verify_job {
+	heap_scan_fn scan;
+	const uint8_t *ptr;
+	size_t start;
+	size_t end;
+	uint64_t arg;
+	int pattern;
+	size_t *first;
+};
+
+static inline void *heap_verify_worker(void *data)
+{
+	struct heap_verify_job *job = (struct heap_verify_job *)data;
+	size_t off;
+
+	for (off = job->start; off < job->end; off += HEAP_VERIFY_BLOCK) {
+		size_t len = job->end - off < HEAP_VERIFY_BLOCK ? job->end - off : HEAP_VERIFY_BLOCK;
+		uint64_t arg = job->pattern ? job->arg + off / 8 : job->arg;
+		size_t found;
+
+		if (__atomic_load_n(job->first, __ATOMIC_RELAXED) <= off)
+			break;
+
+		found = job->scan(job->ptr + off, len, arg);
+		if (found < len) {
+			size_t prev = __atomic_load_n(job->first, __ATOMIC_RELAXED);
+			found += off;
+			while (found < prev &&
+			       !__atomic_compare_exchange_n(job->first, &prev, found, 0,
+							    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Scan ptr[0..len) for the fill byte or pattern in arg on up to threads
+ * threads, 0 for one per CPU and HEAP_VERIFY_THREAD_MIN bytes. Returns
+ * the offset of the first mismatch, or len if there is none.
+ */
+static inline size_t heap_verify(const void *ptr, size_t len, uint64_t arg, int pattern,
+				 unsigned int threads)
+{
+	struct heap_verify_job jobs[HEAP_VERIFY_MAX_THREADS];
+	pthread_t tids[HEAP_VERIFY_MAX_THREADS];
+	int started[HEAP_VERIFY_MAX_THREADS];
+	heap_scan_fn fill_scan, pattern_scan;
+	size_t first = len;
+	size_t nthreads, chunk, i;
+	long cpus;
+
+	heap_verify_scanners(&fill_scan, &pattern_scan);
+
+	nthreads = threads;
+	if (!nthreads) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = len / HEAP_VERIFY_THREAD_MIN;
+		if (cpus > 0 && nthreads > (size_t)cpus)
+			nthreads = cpus;
+	}
+	if (nthreads > HEAP_VERIFY_MAX_THREADS)
+		nthreads = HEAP_VERIFY_MAX_THREADS;
+	if (nthreads < 1)
+		nthreads = 1;
+
+	/* Chunks start on a block boundary, which also keeps pattern words whole */
+	chunk = (len / nthreads + HEAP_VERIFY_BLOCK - 1) / HEAP_VERIFY_BLOCK * HEAP_VERIFY_BLOCK;
+
+	for (i = 0; i < nthreads; i++) {
+		jobs[i].scan = pattern ? pattern_scan : fill_scan;
+		jobs[i].ptr = (const uint8_t *)ptr;
+		jobs[i].start = i * chunk < len ? i * chunk : len;
+		jobs[i].end = (i + 1) * chunk < len ? (i + 1) * chunk : len;
+		jobs[i].arg = arg;
+		jobs[i].pattern = pattern;
+		jobs[i].first = &first;
+		started[i] = 0;
+	}
+
+	for (i = 1; i < nthreads; i++)
+		started[i] = !pthread_create(&tids[i], NULL, heap_verify_worker, &jobs[i]);
+	heap_verify_worker(&jobs[0]);
+	for (i = 1; i < nthreads; i++) {
+		if (started[i])
+			pthread_join(tids[i], NULL);
+		else
+			heap_verify_worker(&jobs[i]);
+	}
+
+	return first;
+}
+
+/*
+ * Check every byte of ptr[0..len) equals c. Returns the offset of the
+ * first byte that does not, or len if they all do.
+ */
+static inline size_t heap_verify_fill(const void *ptr, size_t len, int c)
+{
+	return heap_verify(ptr, len, (uint8_t)c, 0, 0);
+}
+
+/*
+ * Check ptr[0..len) holds the pattern for seed. Returns the offset of the
+ * first byte that does not match, or len if they all do.
+ */
+static inline size_t heap_verify_pattern(const void *ptr, size_t len, uint64_t seed)
+{
+	return heap_verify(ptr, len, seed, 1, 0);
+}
+
+static inline void heap_fill_pattern(void *ptr, size_t len, uint64_t seed)
+{
+	uint8_t *p = (uint8_t *)ptr;
+	uint64_t word = seed * HEAP_PATTERN_MULT;
+	size_t i = 0;
+
+	for (; i + 8 <= len; i += 8, word += HEAP_PATTERN_MULT)
+		memcpy(p + i, &word, 8);
+	if (i < len)
+		memcpy(p + i, &word, len - i);
+}
+
+__END_DECLS
+
+#endif /* HEAP_VERIFY_H_ */
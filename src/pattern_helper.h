@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PATTERN_HELPER_H_
+#define PATTERN_HELPER_H_
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "heap_kernels.h"
+
+__BEGIN_DECLS
+
+/* Same encoding as fourcc_code() from drm_fourcc.h */
+#define PATTERN_FOURCC(a, b, c, d) \
+	((uint32_t)(a) | ((uint32_t)(b) << 8) | \
+	 ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define PATTERN_MAX_PLANES 2
+
+/* Row pitch alignment, a cache line which also suits display engines */
+#define PATTERN_PITCH_ALIGN 64
+/* Each plane starts on its own page within the buffer */
+#define PATTERN_PLANE_ALIGN 4096
+
+/*
+ * A pixel format as laid out in memory. cpp is the bytes per pixel, or
+ * per chroma sample on a subsampled plane, hsub and vsub the subsampling
+ * of each plane. Widths and rotations must be a multiple of xalign so
+ * pixels sharing chroma are never split.
+ */
+struct pattern_format {
+	const char *name;
+	uint32_t fourcc;
+	unsigned int num_planes;
+	unsigned int cpp[PATTERN_MAX_PLANES];
+	unsigned int hsub[PATTERN_MAX_PLANES];
+	unsigned int vsub[PATTERN_MAX_PLANES];
+	unsigned int xalign;
+};
+
+static const struct pattern_format pattern_formats[] = {
+	{ "XRGB8888", PATTERN_FOURCC('X', 'R', '2', '4'), 1, { 4 }, { 1 }, { 1 }, 1 },
+	{ "RGB565", PATTERN_FOURCC('R', 'G', '1', '6'), 1, { 2 }, { 1 }, { 1 }, 1 },
+	{ "YUYV", PATTERN_FOURCC('Y', 'U', 'Y', 'V'), 1, { 2 }, { 1 }, { 1 }, 2 },
+	{ "NV12", PATTERN_FOURCC('N', 'V', '1', '2'), 2, { 1, 2 }, { 1, 2 }, { 1, 2 }, 2 },
+};
+
+/* Returns the formats in turn, NULL past the last one */
+static inline const struct pattern_format *pattern_format_get(unsigned int idx)
+{
+	if (idx >= sizeof(pattern_formats) / sizeof(pattern_formats[0]))
+		return NULL;
+
+	return &pattern_formats[idx];
+}
+
+static inline const struct pattern_format *pattern_format_find(const char *name)
+{
+	const struct pattern_format *format;
+	unsigned int i;
+
+	for (i = 0; (format = pattern_format_get(i)); i++)
+		if (!strcasecmp(format->name, name))
+			return format;
+
+	return NULL;
+}
+
+static inline size_t pattern_row_bytes(const struct pattern_format *format,
+				       unsigned int plane, unsigned int width)
+{
+	return (size_t)width / format->hsub[plane] * format->cpp[plane];
+}
+
+static inline unsigned int pattern_rows(const struct pattern_format *format,
+					unsigned int plane, unsigned int height)
+{
+	return height / format->vsub[plane];
+}
+
+/* Where each plane lives in a single buffer */
+struct pattern_layout {
+	uint32_t pitches[PATTERN_MAX_PLANES];
+	uint32_t offsets[PATTERN_MAX_PLANES];
+	size_t size;
+};
+
+#define PATTERN_ALIGN(x, a) (((x) + (a) - 1) / (a) * (a))
+
+/* Returns 0 or -EINVAL if the frame size does not fit the subsampling */
+static inline int pattern_layout_get(const struct pattern_format *format, unsigned int width,
+				     unsigned int height, struct pattern_layout *layout)
+{
+	size_t size = 0;
+	unsigned int p;
+
+	if (!width || !height || width % format->xalign)
+		return -EINVAL;
+
+	memset(layout, 0, sizeof(*layout));
+	for (p = 0; p < format->num_planes; p++) {
+		if (height % format->vsub[p])
+			return -EINVAL;
+
+		size = PATTERN_ALIGN(size, PATTERN_PLANE_ALIGN);
+		layout->offsets[p] = size;
+		layout->pitches[p] = PATTERN_ALIGN(pattern_row_bytes(format, p, width),
+						   PATTERN_PITCH_ALIGN);
+		size += (size_t)layout->pitches[p] * pattern_rows(format, p, height);
+	}
+	layout->size = PATTERN_ALIGN(size, PATTERN_PLANE_ALIGN);
+
+	return 0;
+}
+
+#define PATTERN_RGB(r, g, b) (0xff000000 | ((r) << 16) | ((g) << 8) | (b))
+
+struct pattern_yuv {
+	uint8_t y;
+	uint8_t u;
+	uint8_t v;
+};
+
+/* BT.601, limited range */
+static inline struct pattern_yuv pattern_rgb_to_yuv(uint32_t rgb)
+{
+	int r = (rgb >> 16) & 0xff;
+	int g = (rgb >> 8) & 0xff;
+	int b = rgb & 0xff;
+	struct pattern_yuv yuv;
+
+	yuv.y = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+	yuv.u = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+	yuv.v = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+
+	return yuv;
+}
+
+/* Convert one line of XRGB pixels into the given plane's memory layout */
+static inline void pattern_pack_line(const struct pattern_format *format, unsigned int plane,
+				     const uint32_t *rgb, unsigned int width, uint8_t *out)
+{
+	unsigned int x;
+
+	switch (format->fourcc) {
+	case PATTERN_FOURCC('X', 'R', '2', '4'):
+		memcpy(out, rgb, width * sizeof(*rgb));
+		break;
+	case PATTERN_FOURCC('R', 'G', '1', '6'):
+		for (x = 0; x < width; x++) {
+			uint16_t pixel = ((rgb[x] >> 8) & 0xf800) |
+					 ((rgb[x] >> 5) & 0x07e0) |
+					 ((rgb[x] >> 3) & 0x001f);
+			out[x * 2 + 0] = pixel & 0xff;
+			out[x * 2 + 1] = pixel >> 8;
+		}
+		break;
+	case PATTERN_FOURCC('Y', 'U', 'Y', 'V'):
+		for (x = 0; x < width; x += 2) {
+			struct pattern_yuv yuv0 = pattern_rgb_to_yuv(rgb[x]);
+			struct pattern_yuv yuv1 = pattern_rgb_to_yuv(rgb[x + 1]);
+			out[x * 2 + 0] = yuv0.y;
+			out[x * 2 + 1] = (yuv0.u + yuv1.u + 1) / 2;
+			out[x * 2 + 2] = yuv1.y;
+			out[x * 2 + 3] = (yuv0.v + yuv1.v + 1) / 2;
+		}
+		break;
+	case PATTERN_FOURCC('N', 'V', '1', '2'):
+		if (plane == 0) {
+			for (x = 0; x < width; x++)
+				out[x] = pattern_rgb_to_yuv(rgb[x]).y;
+			break;
+		}
+		for (x = 0; x < width; x += 2) {
+			struct pattern_yuv yuv0 = pattern_rgb_to_yuv(rgb[x]);
+			struct pattern_yuv yuv1 = pattern_rgb_to_yuv(rgb[x + 1]);
+			out[x + 0] = (yuv0.u + yuv1.u + 1) / 2;
+			out[x + 1] = (yuv0.v + yuv1.v + 1) / 2;
+		}
+		break;
+	}
+}
+
+/* SMPTE color bars, the frame is split into three bands of distinct lines */
+static inline unsigned int pattern_smpte_band(unsigned int y, unsigned int height)
+{
+	if (y < height * 6 / 9)
+		return 0;
+	if (y < height * 7 / 9)
+		return 1;
+
+	return 2;
+}
+
+static inline void pattern_smpte_line(unsigned int band, uint32_t *line, unsigned int width)
+{
+	static const uint32_t colors_top[] = {
+		PATTERN_RGB(192, 192, 192),	/* grey */
+		PATTERN_RGB(192, 192, 0),	/* yellow */
+		PATTERN_RGB(0, 192, 192),	/* cyan */
+		PATTERN_RGB(0, 192, 0),		/* green */
+		PATTERN_RGB(192, 0, 192),	/* magenta */
+		PATTERN_RGB(192, 0, 0),		/* red */
+		PATTERN_RGB(0, 0, 192),		/* blue */
+	};
+	static const uint32_t colors_middle[] = {
+		PATTERN_RGB(0, 0, 192),		/* blue */
+		PATTERN_RGB(19, 19, 19),	/* black */
+		PATTERN_RGB(192, 0, 192),	/* magenta */
+		PATTERN_RGB(19, 19, 19),	/* black */
+		PATTERN_RGB(0, 192, 192),	/* cyan */
+		PATTERN_RGB(19, 19, 19),	/* black */
+		PATTERN_RGB(192, 192, 192),	/* grey */
+	};
+	static const uint32_t colors_bottom[] = {
+		PATTERN_RGB(0, 33, 76),		/* in-phase */
+		PATTERN_RGB(255, 255, 255),	/* super white */
+		PATTERN_RGB(50, 0, 106),	/* quadrature */
+		PATTERN_RGB(19, 19, 19),	/* black */
+		PATTERN_RGB(9, 9, 9),		/* 3.5% */
+		PATTERN_RGB(19, 19, 19),	/* black */
+		PATTERN_RGB(29, 29, 29),	/* 11.5% */
+		PATTERN_RGB(19, 19, 19),	/* black */
+	};
+	unsigned int x;
+
+	switch (band) {
+	case 0:
+		for (x = 0; x < width; ++x)
+			line[x] = colors_top[x * 7 / width];
+		break;
+	case 1:
+		for (x = 0; x < width; ++x)
+			line[x] = colors_middle[x * 7 / width];
+		break;
+	default: {
+		/* the divisors are never 0 while their loop runs, however narrow */
+		unsigned int left = width * 5 / 7, right = width * 6 / 7;
+
+		for (x = 0; x < left; ++x)
+			line[x] = colors_bottom[x * 4 / left];
+		for (; x < right; ++x)
+			line[x] = colors_bottom[(x - left) * 3 / (right - left) + 4];
+		for (; x < width; ++x)
+			line[x] = colors_bottom[7];
+		break;
+	}
+	}
+}
+
+/* Copy one packed line into a row, rotated left by shift bytes */
+static inline void pattern_copy_row(const struct heap_kernels *kernels, uint8_t *row,
+				    const uint8_t *line, size_t row_bytes, size_t shift)
+{
+	kernels->copy(row, line + shift, row_bytes - shift);
+	if (shift)
+		kernels->copy(row + row_bytes - shift, line, shift);
+}
+
+/* Bytes of scratch memory pattern_fill_smpte() needs for a frame width */
+static inline size_t pattern_scratch_bytes(unsigned int width)
+{
+	return 2 * (size_t)width * sizeof(uint32_t);
+}
+
+/*
+ * Fill every plane with SMPTE color bars, scrolled left by offset pixels.
+ * Heap mappings may well be uncached, so each distinct line is converted
+ * to the format once in normal memory and only whole rows are streamed
+ * out with the kernels, the bytes written per frame shrink with the
+ * format. Row padding is left untouched. The lines are built in scratch,
+ * pattern_scratch_bytes(width) of it, allocated once by the caller so
+ * no allocation is timed along with the fill.
+ */
+static inline void pattern_fill_smpte(const struct heap_kernels *kernels,
+				      const struct pattern_format *format,
+				      const struct pattern_layout *layout, void *mem,
+				      unsigned int width, unsigned int height,
+				      unsigned int offset, void *scratch)
+{
+	uint32_t *rgb = (uint32_t *)scratch;
+	uint8_t *line = (uint8_t *)(rgb + width);
+	unsigned int p;
+
+	offset %= width;
+	offset -= offset % format->xalign;
+
+	for (p = 0; p < format->num_planes; p++) {
+		size_t row_bytes = pattern_row_bytes(format, p, width);
+		size_t shift = pattern_row_bytes(format, p, offset);
+		uint8_t *row = (uint8_t *)mem + layout->offsets[p];
+		unsigned int rows = pattern_rows(format, p, height);
+		unsigned int band = -1;
+		unsigned int r;
+
+		for (r = 0; r < rows; r++) {
+			unsigned int b = pattern_smpte_band(r * format->vsub[p], height);
+			if (b != band) {
+				pattern_smpte_line(b, rgb, width);
+				pattern_pack_line(format, p, rgb, width, line);
+				band = b;
+			}
+			pattern_copy_row(kernels, row, line, row_bytes, shift);
+			row += layout->pitches[p];
+		}
+	}
+}
+
+/* Bytes of pixel data in a frame, without the row and plane padding */
+static inline size_t pattern_frame_bytes(const struct pattern_format *format,
+					 unsigned int width, unsigned int height)
+{
+	size_t bytes = 0;
+	unsigned int p;
+
+	for (p = 0; p < format->num_planes; p++)
+		bytes += pattern_row_bytes(format, p, width) * pattern_rows(format, p, height);
+
+	return bytes;
+}
+
+__END_DECLS
+
+#endif /* PATTERN_HELPER_H_ */
@@ -14,13 +14,13 @@
  * limitations under the License.
  */
 
-#include <memory>
 #include <sys/mman.h>
 
 #include <gtest/gtest.h>
 
 #include "heap_test_fixture.h"
 #include "heap_helper.h"
+#include "heap_verify.h"
 
 class Allocate: public HeapAllHeapsTest {};
 
@@ -59,43 +59,45 @@ TEST_F(Allocate, RepeatedAllocate)
 
 TEST_F(Allocate, Zeroed)
 {
-	auto zeroes_ptr = std::make_unique<char[]>(4096);
-
+	static const size_t allocationSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 2 * 1024 * 1024 };
 	for (struct Heap heap : m_allHeaps) {
-		SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
-		int fds[16];
-		for (unsigned int i = 0; i < 16; i++) {
-			int map_fd = -1;
+		for (size_t size : allocationSizes) {
+			SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+			SCOPED_TRACE(::testing::Message() << "size " << size);
+			int fds[16];
+			for (unsigned int i = 0; i < 16; i++) {
+				int map_fd = -1;
 
-			ASSERT_EQ(0, heap_alloc(heap.fd, 4096, 0, &map_fd));
-			ASSERT_GE(map_fd, 0);
+				ASSERT_EQ(0, heap_alloc(heap.fd, size, 0, &map_fd));
+				ASSERT_GE(map_fd, 0);
 
-			void *ptr = mmap(NULL, 4096, PROT_WRITE, MAP_SHARED, map_fd, 0);
-			ASSERT_TRUE(ptr != MAP_FAILED);
+				void *ptr = mmap(NULL, size, PROT_WRITE, MAP_SHARED, map_fd, 0);
+				ASSERT_TRUE(ptr != MAP_FAILED);
 
-			memset(ptr, 0xaa, 4096);
+				memset(ptr, 0xaa, size);
 
-			ASSERT_EQ(0, munmap(ptr, 4096));
-			fds[i] = map_fd;
-		}
+				ASSERT_EQ(0, munmap(ptr, size));
+				fds[i] = map_fd;
+			}
 
-		for (unsigned int i = 0; i < 16; i++) {
-			ASSERT_EQ(0, close(fds[i]));
-		}
+			for (unsigned int i = 0; i < 16; i++) {
+				ASSERT_EQ(0, close(fds[i]));
+			}
 
-		int map_fd = -1;
+			int map_fd = -1;
 
-		ASSERT_EQ(0, heap_alloc(heap.fd, 4096, 0, &map_fd));
-		ASSERT_GE(map_fd, 0);
+			ASSERT_EQ(0, heap_alloc(heap.fd, size, 0, &map_fd));
+			ASSERT_GE(map_fd, 0);
 
-		void *ptr = NULL;
-		ptr = mmap(NULL, 4096, PROT_READ, MAP_SHARED, map_fd, 0);
-		ASSERT_TRUE(ptr != NULL);
+			void *ptr = NULL;
+			ptr = mmap(NULL, size, PROT_READ, MAP_SHARED, map_fd, 0);
+			ASSERT_TRUE(ptr != MAP_FAILED);
 
-		ASSERT_EQ(0, memcmp(ptr, zeroes_ptr.get(), 4096));
+			ASSERT_EQ(size, heap_verify_fill(ptr, size, 0));
 
-		ASSERT_EQ(0, munmap(ptr, 4096));
-		ASSERT_EQ(0, close(map_fd));
+			ASSERT_EQ(0, munmap(ptr, size));
+			ASSERT_EQ(0, close(map_fd));
+		}
 	}
 }
 
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <set>
+#include <fcntl.h>
+
+#include <gtest/gtest.h>
+
+#include "heap_test_fixture.h"
+#include "heap_batch.h"
+
+class Batch: public HeapAllHeapsTest {};
+
+/* Fails every request of failLen, counts the buffers handed out */
+static const size_t failLen = 12345;
+static std::atomic<int> liveBuffers;
+
+static int fake_alloc(int, size_t len, unsigned int, int *dmabuf_fd)
+{
+	if (len == failLen)
+		return -ENOMEM;
+	*dmabuf_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	liveBuffers++;
+
+	return 0;
+}
+
+static int open_fds()
+{
+	int count = 0;
+
+	for (int fd = 0; fd < 1024; fd++)
+		if (fcntl(fd, F_GETFD) >= 0)
+			count++;
+
+	return count;
+}
+
+static void fake_release(std::vector<struct HeapBatch::Result> *results)
+{
+	for (const struct HeapBatch::Result &result : *results)
+		if (result.fd >= 0)
+			liveBuffers--;
+	HeapBatch::release(results);
+}
+
+TEST_F(Batch, AllocateAll)
+{
+	static const size_t allocationSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 2 * 1024 * 1024 };
+	static const unsigned int threadCounts[] = { 1, 4 };
+	for (unsigned int threads : threadCounts) {
+		HeapBatch batch(threads);
+		SCOPED_TRACE(::testing::Message() << "threads " << batch.threads());
+
+		/* every size from every heap in a single batch */
+		std::vector<struct HeapBatch::Request> requests;
+		for (struct Heap heap : m_allHeaps)
+			for (size_t size : allocationSizes)
+				for (int i = 0; i < 4; i++)
+					requests.push_back({ (int)heap.fd, size, 0 });
+
+		std::vector<struct HeapBatch::Result> results;
+		ASSERT_EQ(0, batch.allocate(requests, HeapBatch::BATCH_ALL_OR_NOTHING, &results));
+		ASSERT_EQ(requests.size(), results.size());
+
+		std::set<int> fds;
+		for (size_t i = 0; i < results.size(); i++) {
+			SCOPED_TRACE(::testing::Message() << "request " << i);
+			ASSERT_EQ(0, results[i].error);
+			ASSERT_GE(results[i].fd, 0);
+			ASSERT_EQ((off_t)requests[i].len, lseek(results[i].fd, 0, SEEK_END));
+			fds.insert(results[i].fd);
+		}
+		ASSERT_EQ(results.size(), fds.size());
+
+		HeapBatch::release(&results);
+		for (const struct HeapBatch::Result &result : results)
+			ASSERT_EQ(-1, result.fd);
+	}
+}
+
+TEST_F(Batch, AllOrNothing)
+{
+	static const unsigned int threadCounts[] = { 1, 4 };
+	for (unsigned int threads : threadCounts) {
+		SCOPED_TRACE(::testing::Message() << "threads " << threads);
+		HeapBatch batch(threads, fake_alloc);
+		std::vector<struct HeapBatch::Request> requests(64, HeapBatch::Request{ 0, 4096, 0 });
+		std::vector<struct HeapBatch::Result> results;
+
+		requests[37].len = failLen;
+		int before = open_fds();
+		ASSERT_EQ(-ENOMEM, batch.allocate(requests, HeapBatch::BATCH_ALL_OR_NOTHING, &results));
+		ASSERT_EQ(requests.size(), results.size());
+		for (const struct HeapBatch::Result &result : results) {
+			ASSERT_EQ(-1, result.fd);
+			ASSERT_NE(0, result.error);
+		}
+		ASSERT_EQ(-ENOMEM, results[37].error);
+		/* the buffers allocated before the failure were closed again */
+		ASSERT_EQ(before, open_fds());
+
+		/* the same pool serves the next batch */
+		requests[37].len = 4096;
+		liveBuffers = 0;
+		ASSERT_EQ(0, batch.allocate(requests, HeapBatch::BATCH_ALL_OR_NOTHING, &results));
+		ASSERT_EQ(64, liveBuffers);
+		fake_release(&results);
+		ASSERT_EQ(0, liveBuffers);
+		ASSERT_EQ(before, open_fds());
+	}
+}
+
+TEST_F(Batch, BestEffort)
+{
+	HeapBatch batch(4, fake_alloc);
+	std::vector<struct HeapBatch::Request> requests(64, HeapBatch::Request{ 0, 4096, 0 });
+	std::vector<struct HeapBatch::Result> results;
+
+	requests[3].len = failLen;
+	requests[50].len = failLen;
+	liveBuffers = 0;
+	ASSERT_EQ(-ENOMEM, batch.allocate(requests, HeapBatch::BATCH_BEST_EFFORT, &results));
+	for (size_t i = 0; i < results.size(); i++) {
+		SCOPED_TRACE(::testing::Message() << "request " << i);
+		if (requests[i].len == failLen) {
+			ASSERT_EQ(-ENOMEM, results[i].error);
+			ASSERT_EQ(-1, results[i].fd);
+		} else {
+			ASSERT_EQ(0, results[i].error);
+			ASSERT_GE(results[i].fd, 0);
+		}
+	}
+	ASSERT_EQ(62, liveBuffers);
+	fake_release(&results);
+	ASSERT_EQ(0, liveBuffers);
+
+	ASSERT_EQ(0, batch.allocate({}, HeapBatch::BATCH_BEST_EFFORT, &results));
+	ASSERT_TRUE(results.empty());
+}
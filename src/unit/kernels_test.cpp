@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <sys/mman.h>
+
+#include <gtest/gtest.h>
+
+#include "heap_test_fixture.h"
+#include "heap_helper.h"
+#include "heap_kernels.h"
+
+class Kernels: public HeapAllHeapsTest {};
+
+static bool valid_kernels(const struct heap_kernels *kernels)
+{
+	const struct heap_kernels *available;
+
+	for (unsigned int k = 0; (available = heap_kernels_get(k)); k++)
+		if (kernels == available)
+			return true;
+
+	return false;
+}
+
+/*
+ * The probe is timing based and its answer depends on the load on the
+ * machine, its accuracy is reported by the Kernels/Probe benchmarks.
+ */
+TEST_F(Kernels, Select)
+{
+	size_t size = 1024 * 1024;
+	void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_TRUE(ptr != MAP_FAILED);
+	memset(ptr, 0, size);
+
+	EXPECT_TRUE(valid_kernels(heap_kernels_select(ptr, size)));
+	/* too small to probe, taken as cached */
+	EXPECT_EQ(&heap_kernels_generic, heap_kernels_select(ptr, 4));
+
+	ASSERT_EQ(0, munmap(ptr, size));
+
+	for (struct Heap heap : m_allHeaps) {
+		SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+		int map_fd = -1;
+
+		ASSERT_EQ(0, heap_alloc(heap.fd, size, 0, &map_fd));
+		ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, map_fd, 0);
+		ASSERT_TRUE(ptr != MAP_FAILED);
+
+		EXPECT_TRUE(valid_kernels(heap_kernels_select(ptr, size)));
+
+		ASSERT_EQ(0, munmap(ptr, size));
+		ASSERT_EQ(0, close(map_fd));
+	}
+}
+
+TEST_F(Kernels, FillCopyRead)
+{
+	static const size_t allocationSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 2 * 1024 * 1024 };
+	/* exercise the unaligned head and tail paths */
+	static const size_t offsets[] = { 0, 1, 17, 63 };
+	for (struct Heap heap : m_allHeaps) {
+		for (size_t size : allocationSizes) {
+			SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+			SCOPED_TRACE(::testing::Message() << "size " << size);
+			int map_fd = -1;
+
+			ASSERT_EQ(0, heap_alloc(heap.fd, size, 0, &map_fd));
+			ASSERT_GE(map_fd, 0);
+
+			uint8_t *ptr = (uint8_t *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, map_fd, 0);
+			ASSERT_TRUE(ptr != MAP_FAILED);
+
+			auto pattern = std::make_unique<uint8_t[]>(size);
+			auto readback = std::make_unique<uint8_t[]>(size);
+			for (size_t i = 0; i < size; i++)
+				pattern[i] = i * 13 + 5;
+
+			const struct heap_kernels *kernels;
+			for (unsigned int k = 0; (kernels = heap_kernels_get(k)); k++) {
+				SCOPED_TRACE(::testing::Message() << "kernels " << kernels->name);
+				for (size_t offset : offsets) {
+					SCOPED_TRACE(::testing::Message() << "offset " << offset);
+					size_t len = size - offset * 2;
+
+					kernels->fill(ptr, 0x00, size);
+					kernels->fill(ptr + offset, 0xaa, len);
+					kernels->read(readback.get(), ptr, size);
+					for (size_t i = 0; i < size; i++) {
+						bool filled = i >= offset && i < offset + len;
+						ASSERT_EQ(filled ? 0xaa : 0x00, readback[i]) << "fill at " << i;
+					}
+
+					kernels->copy(ptr + offset, pattern.get(), len);
+					memset(readback.get(), 0, size);
+					kernels->read(readback.get(), ptr + offset, len);
+					ASSERT_EQ(0, memcmp(pattern.get(), readback.get(), len));
+				}
+			}
+
+			ASSERT_EQ(0, munmap(ptr, size));
+			ASSERT_EQ(0, close(map_fd));
+		}
+	}
+}
@@ -20,6 +20,8 @@
 
 #include "heap_test_fixture.h"
 #include "heap_helper.h"
+#include "heap_kernels.h"
+#include "heap_verify.h"
 
 class Map: public HeapAllHeapsTest {};
 
@@ -41,7 +43,8 @@ TEST_F(Map, MapFd)
 
 			ASSERT_EQ(0, close(map_fd));
 
-			memset(ptr, 0xaa, size);
+			heap_kernels_select(ptr, size)->fill(ptr, 0xaa, size);
+			ASSERT_EQ(size, heap_verify_fill(ptr, size, 0xaa));
 
 			ASSERT_EQ(0, munmap(ptr, size));
 		}
@@ -72,9 +75,45 @@ TEST_F(Map, MapOffset) {
 
 		ASSERT_EQ(ptr[0], 0xaa);
 		ASSERT_EQ(ptr[psize - 1], 0xaa);
+		ASSERT_EQ(psize, heap_verify_fill(ptr, psize, 0xaa));
 
 		ASSERT_EQ(0, munmap(ptr, psize));
 
 		ASSERT_EQ(0, close(map_fd));
 	}
 }
+
+TEST_F(Map, MapOffsetPattern)
+{
+	static const size_t allocationSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 2 * 1024 * 1024 };
+	for (struct Heap heap : m_allHeaps) {
+		for (size_t size : allocationSizes) {
+			SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+			SCOPED_TRACE(::testing::Message() << "size " << size);
+			unsigned long psize = sysconf(_SC_PAGESIZE);
+			int map_fd = -1;
+
+			ASSERT_EQ(0, heap_alloc(heap.fd, size, 0, &map_fd));
+			ASSERT_GE(map_fd, 0);
+
+			void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, map_fd, 0);
+			ASSERT_TRUE(ptr != MAP_FAILED);
+
+			heap_fill_pattern(ptr, size, size);
+			ASSERT_EQ(size, heap_verify_pattern(ptr, size, size));
+
+			ASSERT_EQ(0, munmap(ptr, size));
+
+			/* every page mapped on its own must hold its part of the pattern */
+			for (size_t offset = 0; offset < size; offset += psize) {
+				ptr = mmap(NULL, psize, PROT_READ, MAP_SHARED, map_fd, offset);
+				ASSERT_TRUE(ptr != MAP_FAILED);
+				ASSERT_EQ(psize, heap_verify_pattern(ptr, psize, size + offset / 8))
+					<< "offset " << offset;
+				ASSERT_EQ(0, munmap(ptr, psize));
+			}
+
+			ASSERT_EQ(0, close(map_fd));
+		}
+	}
+}
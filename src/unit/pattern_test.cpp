@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <sys/mman.h>
+
+#include <gtest/gtest.h>
+
+#include "heap_test_fixture.h"
+#include "heap_helper.h"
+#include "pattern_helper.h"
+
+class Pattern: public HeapAllHeapsTest {};
+
+TEST_F(Pattern, Layout)
+{
+	const struct pattern_format *format;
+	struct pattern_layout layout;
+	for (unsigned int n = 0; (format = pattern_format_get(n)); n++) {
+		SCOPED_TRACE(::testing::Message() << "format " << format->name);
+
+		ASSERT_EQ(format, pattern_format_find(format->name));
+		ASSERT_EQ(0, pattern_layout_get(format, 1366, 768, &layout));
+
+		size_t end = 0;
+		for (unsigned int p = 0; p < format->num_planes; p++) {
+			ASSERT_EQ(0u, layout.pitches[p] % PATTERN_PITCH_ALIGN);
+			ASSERT_GE(layout.pitches[p], pattern_row_bytes(format, p, 1366));
+			ASSERT_EQ(0u, layout.offsets[p] % PATTERN_PLANE_ALIGN);
+			ASSERT_GE(layout.offsets[p], end);
+			end = layout.offsets[p] + (size_t)layout.pitches[p] * pattern_rows(format, p, 768);
+		}
+		ASSERT_GE(layout.size, end);
+
+		if (format->xalign > 1) {
+			ASSERT_EQ(-EINVAL, pattern_layout_get(format, 1365, 768, &layout));
+		}
+	}
+	ASSERT_EQ(-EINVAL, pattern_layout_get(pattern_format_find("NV12"), 1366, 767, &layout));
+	ASSERT_TRUE(pattern_format_find("BGR888") == NULL);
+}
+
+TEST_F(Pattern, Narrow)
+{
+	static const unsigned int height = 4;
+	const struct pattern_format *format;
+	for (unsigned int n = 0; (format = pattern_format_get(n)); n++) {
+		SCOPED_TRACE(::testing::Message() << "format " << format->name);
+		/* fewer pixels than bars, down to a single pixel */
+		for (unsigned int width = format->xalign; width <= 16; width += format->xalign) {
+			SCOPED_TRACE(::testing::Message() << "width " << width);
+			struct pattern_layout layout;
+
+			ASSERT_EQ(0, pattern_layout_get(format, width, height, &layout));
+			auto mem = std::make_unique<uint8_t[]>(layout.size);
+			auto scratch = std::make_unique<uint8_t[]>(pattern_scratch_bytes(width));
+			pattern_fill_smpte(&heap_kernels_generic, format, &layout, mem.get(),
+					   width, height, 1, scratch.get());
+		}
+	}
+}
+
+TEST_F(Pattern, Fill)
+{
+	static const unsigned int width = 320, height = 180, scroll = 64;
+	const uint32_t grey = PATTERN_RGB(192, 192, 192);
+	const struct pattern_yuv yuv = pattern_rgb_to_yuv(grey);
+	auto scratch = std::make_unique<uint8_t[]>(pattern_scratch_bytes(width));
+	for (struct Heap heap : m_allHeaps) {
+		const struct pattern_format *format;
+		for (unsigned int n = 0; (format = pattern_format_get(n)); n++) {
+			SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+			SCOPED_TRACE(::testing::Message() << "format " << format->name);
+			struct pattern_layout layout;
+			int map_fd = -1;
+
+			ASSERT_EQ(0, pattern_layout_get(format, width, height, &layout));
+			ASSERT_EQ(0, heap_alloc(heap.fd, layout.size, 0, &map_fd));
+			ASSERT_GE(map_fd, 0);
+
+			uint8_t *ptr = (uint8_t *)mmap(NULL, layout.size, PROT_READ | PROT_WRITE, MAP_SHARED, map_fd, 0);
+			ASSERT_TRUE(ptr != MAP_FAILED);
+
+			const struct heap_kernels *kernels = heap_kernels_select(ptr, layout.size);
+			auto first = std::make_unique<uint8_t[]>(layout.size);
+			pattern_fill_smpte(kernels, format, &layout, ptr, width, height, 0, scratch.get());
+			memcpy(first.get(), ptr, layout.size);
+
+			/* the top left pixel is grey */
+			uint8_t *pixel = ptr + layout.offsets[0];
+			switch (format->fourcc) {
+			case PATTERN_FOURCC('X', 'R', '2', '4'):
+				ASSERT_EQ(grey & 0xffffff, *(uint32_t *)pixel & 0xffffff);
+				break;
+			case PATTERN_FOURCC('R', 'G', '1', '6'):
+				ASSERT_EQ(0xc618, pixel[0] | pixel[1] << 8);
+				break;
+			case PATTERN_FOURCC('Y', 'U', 'Y', 'V'):
+				ASSERT_EQ(yuv.y, pixel[0]);
+				ASSERT_EQ(yuv.u, pixel[1]);
+				ASSERT_EQ(yuv.y, pixel[2]);
+				ASSERT_EQ(yuv.v, pixel[3]);
+				break;
+			case PATTERN_FOURCC('N', 'V', '1', '2'):
+				ASSERT_EQ(yuv.y, pixel[0]);
+				ASSERT_EQ(yuv.u, ptr[layout.offsets[1] + 0]);
+				ASSERT_EQ(yuv.v, ptr[layout.offsets[1] + 1]);
+				break;
+			}
+
+			/* every row is the unscrolled row rotated left */
+			pattern_fill_smpte(kernels, format, &layout, ptr, width, height, scroll, scratch.get());
+			for (unsigned int p = 0; p < format->num_planes; p++) {
+				size_t row_bytes = pattern_row_bytes(format, p, width);
+				size_t shift = pattern_row_bytes(format, p, scroll);
+				for (unsigned int r = 0; r < pattern_rows(format, p, height); r++) {
+					SCOPED_TRACE(::testing::Message() << "plane " << p << " row " << r);
+					size_t row = layout.offsets[p] + (size_t)layout.pitches[p] * r;
+					ASSERT_EQ(0, memcmp(ptr + row, first.get() + row + shift, row_bytes - shift));
+					ASSERT_EQ(0, memcmp(ptr + row + row_bytes - shift, first.get() + row, shift));
+				}
+			}
+
+			ASSERT_EQ(0, munmap(ptr, layout.size));
+			ASSERT_EQ(0, close(map_fd));
+		}
+	}
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+
+#include <gtest/gtest.h>
+
+#include "heap_test_fixture.h"
+#include "heap_policy.h"
+
+class Policy: public HeapAllHeapsTest {};
+
+/* Stand-in heaps, the heap fd is the index into the vector */
+struct FakeHeap {
+	int error;
+	std::chrono::microseconds delay;
+	unsigned long calls;
+};
+
+static HeapPolicy::AllocFn fake_alloc(std::vector<struct FakeHeap> &heaps)
+{
+	return [&heaps](int heap_fd, size_t, int *dmabuf_fd) {
+		struct FakeHeap &heap = heaps[heap_fd];
+		heap.calls++;
+		if (heap.delay.count())
+			std::this_thread::sleep_for(heap.delay);
+		if (heap.error)
+			return heap.error;
+		*dmabuf_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+		return 0;
+	};
+}
+
+TEST_F(Policy, GuessFlags)
+{
+	EXPECT_EQ((unsigned int)HeapPolicy::HEAP_CACHED, HeapPolicy::guess_flags("system"));
+	EXPECT_EQ(0u, HeapPolicy::guess_flags("system-uncached"));
+	EXPECT_EQ((unsigned int)(HeapPolicy::HEAP_CONTIGUOUS | HeapPolicy::HEAP_CACHED),
+		  HeapPolicy::guess_flags("reserved"));
+	EXPECT_EQ((unsigned int)(HeapPolicy::HEAP_CONTIGUOUS | HeapPolicy::HEAP_CACHED),
+		  HeapPolicy::guess_flags("linux,cma"));
+}
+
+TEST_F(Policy, Constraints)
+{
+	std::vector<struct FakeHeap> fakes(3, FakeHeap());
+	HeapPolicy policy(fake_alloc(fakes));
+	const HeapPolicy::Constraints any = { false, false, 0 };
+	const HeapPolicy::Constraints contiguous = { true, false, 0 };
+	const HeapPolicy::Constraints cached = { false, true, 0 };
+	int fd, heap;
+
+	ASSERT_EQ(-ENODEV, policy.allocate(4096, any, &fd));
+
+	ASSERT_EQ(0, policy.add_heap("system-uncached", 0));
+	ASSERT_EQ(1, policy.add_heap("system", 1));
+	ASSERT_EQ(-ENODEV, policy.allocate(4096, contiguous, &fd));
+	ASSERT_EQ(2, policy.add_heap("reserved", 2));
+
+	for (int i = 0; i < 100; i++) {
+		ASSERT_EQ(0, policy.allocate(4096, contiguous, &fd, &heap));
+		ASSERT_EQ(2, heap);
+		ASSERT_EQ(0, close(fd));
+
+		ASSERT_EQ(0, policy.allocate(4096, cached, &fd, &heap));
+		ASSERT_NE(0, heap);
+		ASSERT_EQ(0, close(fd));
+	}
+	ASSERT_EQ(0u, fakes[0].calls);
+
+	/* never falls back to a heap that does not meet the constraints */
+	fakes[2].error = -ENOMEM;
+	ASSERT_EQ(-ENOMEM, policy.allocate(4096, contiguous, &fd));
+	ASSERT_EQ(0, policy.allocate(4096, cached, &fd, &heap));
+	ASSERT_EQ(1, heap);
+	ASSERT_EQ(0, close(fd));
+}
+
+TEST_F(Policy, FailureFallback)
+{
+	static const int requests = 1000;
+	std::vector<struct FakeHeap> fakes(2, FakeHeap());
+	HeapPolicy policy(fake_alloc(fakes));
+	const HeapPolicy::Constraints contiguous = { true, true, 0 };
+	int fd, heap;
+
+	policy.add_heap("cma-a", 0);
+	policy.add_heap("cma-b", 1);
+	fakes[0].error = -ENOMEM;
+
+	for (int i = 0; i < requests; i++) {
+		ASSERT_EQ(0, policy.allocate(4096, contiguous, &fd, &heap));
+		ASSERT_EQ(1, heap);
+		ASSERT_EQ(0, close(fd));
+	}
+	/* first failure plus backed off probes: 16, 32, ... 512 requests apart */
+	EXPECT_LE(fakes[0].calls, 7u);
+	EXPECT_TRUE(policy.stats()[0].demoted);
+	EXPECT_GT(policy.stats()[0].failure_rate, 0.5);
+
+	/* recovers within one maximum backoff period */
+	fakes[0].error = 0;
+	for (unsigned int i = 0; i <= HeapPolicy::maxBackoff; i++) {
+		ASSERT_EQ(0, policy.allocate(4096, contiguous, &fd));
+		ASSERT_EQ(0, close(fd));
+	}
+	EXPECT_FALSE(policy.stats()[0].demoted);
+
+	/* nothing left to fall back to */
+	fakes[0].error = -ENOMEM;
+	fakes[1].error = -EBUSY;
+	ASSERT_NE(0, policy.allocate(4096, contiguous, &fd));
+}
+
+TEST_F(Policy, TailLatency)
+{
+	static const int requests = 1000;
+	static const auto stall = std::chrono::milliseconds(30);
+	static const auto budget = std::chrono::milliseconds(5);
+	std::vector<struct FakeHeap> fakes(2, FakeHeap());
+	HeapPolicy policy(fake_alloc(fakes));
+	const HeapPolicy::Constraints constraints = {
+		true, true, (uint64_t)std::chrono::nanoseconds(budget).count()
+	};
+	std::vector<std::chrono::nanoseconds> latencies;
+	int fd;
+
+	/* the preferred heap is fragmented and stalls every allocation */
+	policy.add_heap("cma-a", 0);
+	policy.add_heap("cma-b", 1);
+	fakes[0].delay = stall;
+
+	for (int i = 0; i < requests; i++) {
+		auto start = std::chrono::steady_clock::now();
+		ASSERT_EQ(0, policy.allocate(4096, constraints, &fd));
+		latencies.push_back(std::chrono::steady_clock::now() - start);
+		ASSERT_EQ(0, close(fd));
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	int slow = std::count_if(latencies.begin(), latencies.end(),
+				 [](std::chrono::nanoseconds ns) { return ns > budget; });
+	EXPECT_LE((unsigned long)slow, fakes[0].calls);
+	EXPECT_LE(fakes[0].calls, 7u);
+	EXPECT_LT(latencies[requests * 99 / 100], budget);
+	/* a request never pays for more than one stall */
+	EXPECT_LT(latencies.back(), stall * 2);
+	EXPECT_EQ(fakes[0].calls, policy.stats()[0].budget_misses);
+}
+
+TEST_F(Policy, TailLatencyThreaded)
+{
+	static const int threads = 8;
+	static const int requests = 250;
+	static const auto stall = std::chrono::milliseconds(30);
+	static const auto budget = std::chrono::milliseconds(5);
+	std::atomic<unsigned long> stalls(0);
+	HeapPolicy policy([&stalls](int heap_fd, size_t, int *dmabuf_fd) {
+		if (heap_fd == 0) {
+			stalls++;
+			std::this_thread::sleep_for(stall);
+		}
+		*dmabuf_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+		return 0;
+	});
+	const HeapPolicy::Constraints constraints = {
+		true, true, (uint64_t)std::chrono::nanoseconds(budget).count()
+	};
+	int fd;
+
+	policy.add_heap("cma-a", 0);
+	policy.add_heap("cma-b", 1);
+
+	/* nothing is known before the first request, it pays for the first stall */
+	ASSERT_EQ(0, policy.allocate(4096, constraints, &fd));
+	ASSERT_EQ(0, close(fd));
+	ASSERT_EQ(1u, stalls);
+
+	/* requests arriving while a probe stalls must not probe as well */
+	std::vector<std::vector<std::chrono::nanoseconds>> latencies(threads);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++) {
+		workers.emplace_back([&, t] {
+			for (int i = 0; i < requests; i++) {
+				int buf_fd;
+				auto start = std::chrono::steady_clock::now();
+				if (policy.allocate(4096, constraints, &buf_fd))
+					continue;
+				latencies[t].push_back(std::chrono::steady_clock::now() - start);
+				close(buf_fd);
+			}
+		});
+	}
+	for (std::thread &worker : workers)
+		worker.join();
+
+	std::vector<std::chrono::nanoseconds> all;
+	for (const auto &thread : latencies)
+		all.insert(all.end(), thread.begin(), thread.end());
+	ASSERT_EQ((size_t)threads * requests, all.size());
+	std::sort(all.begin(), all.end());
+
+	/* first stall plus one probe per backoff period: 16, 32, ... 1024 requests */
+	EXPECT_LE(stalls, 8u);
+	EXPECT_LT(all[all.size() * 99 / 100], budget);
+	EXPECT_EQ(stalls, policy.stats()[0].budget_misses);
+}
+
+TEST_F(Policy, AllHeaps)
+{
+	const HeapPolicy::Constraints any = { false, false, 0 };
+	HeapPolicy policy;
+
+	for (struct Heap heap : m_allHeaps)
+		policy.add_heap(heap.dev_name, heap.fd);
+
+	for (size_t i = 0; i < m_allHeaps.size() * 4; i++) {
+		int fd = -1, heap = -1;
+		ASSERT_EQ(0, policy.allocate(64 * 1024, any, &fd, &heap));
+		ASSERT_GE(fd, 0);
+		ASSERT_GE(heap, 0);
+		ASSERT_EQ(0, close(fd));
+	}
+}
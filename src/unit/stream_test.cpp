@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include <gtest/gtest.h>
+
+#include "heap_test_fixture.h"
+#include "heap_helper.h"
+#include "heap_stream.h"
+
+class Stream: public HeapAllHeapsTest {};
+
+TEST_F(Stream, InvalidWindow)
+{
+	for (struct Heap heap : m_allHeaps) {
+		SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+		unsigned long psize = sysconf(_SC_PAGESIZE);
+		int map_fd = -1;
+
+		ASSERT_EQ(0, heap_alloc(heap.fd, psize * 4, 0, &map_fd));
+		ASSERT_GE(map_fd, 0);
+
+		HeapStream stream;
+		/* not a page multiple */
+		EXPECT_EQ(-EINVAL, stream.open(map_fd, psize * 4, psize + 1, 2));
+		/* no room to prefetch */
+		EXPECT_EQ(-EINVAL, stream.open(map_fd, psize * 4, psize, 1));
+		/* zero size */
+		EXPECT_EQ(-EINVAL, stream.open(map_fd, 0, psize, 2));
+
+		ASSERT_EQ(0, stream.open(map_fd, psize * 4, psize, 2));
+		EXPECT_EQ(-EBUSY, stream.open(map_fd, psize * 4, psize, 2));
+		stream.close();
+
+		ASSERT_EQ(0, close(map_fd));
+	}
+}
+
+TEST_F(Stream, Read)
+{
+	static const size_t windowSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024 };
+	static const size_t size = 2 * 1024 * 1024 + 4096;
+	for (struct Heap heap : m_allHeaps) {
+		SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+		int map_fd = -1;
+
+		ASSERT_EQ(0, heap_alloc(heap.fd, size, 0, &map_fd));
+		ASSERT_GE(map_fd, 0);
+
+		uint8_t *ptr = (uint8_t *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, map_fd, 0);
+		ASSERT_TRUE(ptr != MAP_FAILED);
+		for (size_t i = 0; i < size; i++)
+			ptr[i] = i * 7;
+		ASSERT_EQ(0, munmap(ptr, size));
+
+		for (size_t window : windowSizes) {
+			SCOPED_TRACE(::testing::Message() << "window " << window);
+			HeapStream stream;
+			ASSERT_EQ(0, stream.open(map_fd, size, window, 2, PROT_READ));
+
+			uint64_t expected = 0;
+			for (auto &chunk : stream.read()) {
+				ASSERT_EQ(expected, chunk.offset());
+				ASSERT_LE(chunk.size(), window);
+				for (size_t i = 0; i < chunk.size(); i++)
+					ASSERT_EQ((uint8_t)((chunk.offset() + i) * 7), chunk.data()[i]);
+				expected += chunk.size();
+			}
+			ASSERT_EQ(size, expected);
+			ASSERT_EQ(0, stream.error());
+		}
+
+		ASSERT_EQ(0, close(map_fd));
+	}
+}
+
+TEST_F(Stream, Write)
+{
+	static const size_t size = 2 * 1024 * 1024;
+	static const size_t window = 64 * 1024;
+	for (struct Heap heap : m_allHeaps) {
+		SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+		int map_fd = -1;
+
+		ASSERT_EQ(0, heap_alloc(heap.fd, size, 0, &map_fd));
+		ASSERT_GE(map_fd, 0);
+
+		{
+			HeapStream stream;
+			ASSERT_EQ(0, stream.open(map_fd, size, window, 3));
+
+			/* unaligned start and length */
+			auto range = stream.write(window / 2, size - window);
+			for (auto it = range.begin(); it != range.end(); ++it)
+				memset(it.data(), 0xaa, it.size());
+			ASSERT_EQ(0, stream.error());
+		}
+
+		uint8_t *ptr = (uint8_t *)mmap(NULL, size, PROT_READ, MAP_SHARED, map_fd, 0);
+		ASSERT_TRUE(ptr != MAP_FAILED);
+		for (size_t i = 0; i < size; i++) {
+			bool written = i >= window / 2 && i < size - window / 2;
+			ASSERT_EQ(written ? 0xaa : 0x00, ptr[i]) << "offset " << i;
+		}
+		ASSERT_EQ(0, munmap(ptr, size));
+
+		ASSERT_EQ(0, close(map_fd));
+	}
+}
+
+TEST_F(Stream, Prefetch)
+{
+	static const size_t window = 64 * 1024;
+	static const unsigned int windows = 16;
+	static const size_t size = window * windows;
+	for (struct Heap heap : m_allHeaps) {
+		SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+		int map_fd = -1;
+
+		ASSERT_EQ(0, heap_alloc(heap.fd, size, 0, &map_fd));
+		ASSERT_GE(map_fd, 0);
+
+		HeapStream stream;
+		ASSERT_EQ(0, stream.open(map_fd, size, window, 3, PROT_READ));
+
+		unsigned int n = 0;
+		for (auto &chunk : stream.read()) {
+			ASSERT_EQ(window, chunk.size());
+			/* give the helper thread time to map the next window ahead of us */
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (n + 1 < windows && stream.stats().maps < n + 2 &&
+			       std::chrono::steady_clock::now() < deadline)
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			n++;
+		}
+		ASSERT_EQ(windows, n);
+		ASSERT_EQ(0, stream.error());
+
+		/* each window mapped exactly once, all but the first by the helper */
+		struct HeapStream::Stats stats = stream.stats();
+		EXPECT_EQ(windows, stats.maps);
+		EXPECT_EQ(windows - 1, stats.prefetched);
+		EXPECT_EQ(windows - 1, stats.hits);
+
+		stream.close();
+		ASSERT_EQ(0, close(map_fd));
+	}
+}
+
+TEST_F(Stream, MapError)
+{
+	int fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+	ASSERT_GE(fd, 0);
+
+	HeapStream stream;
+	ASSERT_EQ(0, stream.open(fd, 1024 * 1024, 64 * 1024, 2));
+
+	/* the loop just ends, the error stays with the stream */
+	uint64_t seen = 0;
+	for (auto &chunk : stream.read())
+		seen += chunk.size();
+	EXPECT_EQ(0u, seen);
+	EXPECT_NE(0, stream.error());
+
+	stream.close();
+	ASSERT_EQ(0, close(fd));
+}
+
+TEST_F(Stream, WindowReuse)
+{
+	for (struct Heap heap : m_allHeaps) {
+		SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+		unsigned long psize = sysconf(_SC_PAGESIZE);
+		int map_fd = -1;
+
+		ASSERT_EQ(0, heap_alloc(heap.fd, psize * 8, 0, &map_fd));
+		ASSERT_GE(map_fd, 0);
+
+		HeapStream stream;
+		ASSERT_EQ(0, stream.open(map_fd, psize * 8, psize, 3, PROT_READ | PROT_WRITE, false));
+
+		struct HeapStream::Chunk chunk;
+		/* window 0 and 1 stay resident, 2 then 3 take the last slot */
+		static const unsigned int accesses[] = { 0, 1, 0, 2, 1, 0, 3, 1, 0 };
+		for (unsigned int window : accesses) {
+			ASSERT_EQ(0, stream.acquire(window * psize, &chunk));
+			ASSERT_EQ(psize, chunk.len);
+			chunk.ptr[0] = window;
+			stream.release(chunk);
+		}
+
+		struct HeapStream::Stats stats = stream.stats();
+		EXPECT_EQ(4u, stats.maps);
+		EXPECT_EQ(5u, stats.hits);
+
+		/* past the end */
+		EXPECT_EQ(-EINVAL, stream.acquire(psize * 8, &chunk));
+
+		stream.close();
+		ASSERT_EQ(0, close(map_fd));
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/mman.h>
+
+#include <gtest/gtest.h>
+
+#include "heap_test_fixture.h"
+#include "heap_helper.h"
+#include "heap_verify.h"
+
+class Verify: public HeapAllHeapsTest {};
+
+TEST_F(Verify, Mismatch)
+{
+	static const size_t allocationSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 2 * 1024 * 1024 };
+	for (struct Heap heap : m_allHeaps) {
+		for (size_t size : allocationSizes) {
+			SCOPED_TRACE(::testing::Message() << "heap " << heap.dev_name);
+			SCOPED_TRACE(::testing::Message() << "size " << size);
+			int map_fd = -1;
+
+			ASSERT_EQ(0, heap_alloc(heap.fd, size, 0, &map_fd));
+			ASSERT_GE(map_fd, 0);
+
+			uint8_t *ptr = (uint8_t *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, map_fd, 0);
+			ASSERT_TRUE(ptr != MAP_FAILED);
+
+			const size_t offsets[] = { 0, 1, 127, 128, size / 2 + 3, size - 1 };
+			for (size_t offset : offsets) {
+				SCOPED_TRACE(::testing::Message() << "offset " << offset);
+
+				memset(ptr, 0x5a, size);
+				ASSERT_EQ(size, heap_verify_fill(ptr, size, 0x5a));
+				ptr[offset] = 0x5b;
+				ASSERT_EQ(offset, heap_verify_fill(ptr, size, 0x5a));
+				/* only the first one is reported */
+				ptr[size - 1] ^= 0x01;
+				ASSERT_EQ(offset == size - 1 ? size : offset, heap_verify_fill(ptr, size, 0x5a));
+
+				heap_fill_pattern(ptr, size, 42);
+				ASSERT_EQ(size, heap_verify_pattern(ptr, size, 42));
+				ASSERT_EQ(0u, heap_verify_pattern(ptr, size, 43));
+				ptr[offset] ^= 0x80;
+				ASSERT_EQ(offset, heap_verify_pattern(ptr, size, 42));
+			}
+
+			ASSERT_EQ(0, munmap(ptr, size));
+			ASSERT_EQ(0, close(map_fd));
+		}
+	}
+}
+
+TEST_F(Verify, Threaded)
+{
+	/* forced onto several threads, the default is one per CPU */
+	static const unsigned int threadCounts[] = { 2, 3, 8 };
+	size_t size = 64 * 1024 * 1024;
+	uint8_t *ptr = (uint8_t *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_TRUE(ptr != MAP_FAILED);
+
+	for (unsigned int threads : threadCounts) {
+		SCOPED_TRACE(::testing::Message() << "threads " << threads);
+
+		memset(ptr, 0, size);
+		EXPECT_EQ(size, heap_verify(ptr, size, 0, 0, threads));
+		ptr[size - 5] = 1;
+		EXPECT_EQ(size - 5, heap_verify(ptr, size, 0, 0, threads));
+		ptr[size / 3] = 1;
+		EXPECT_EQ(size / 3, heap_verify(ptr, size, 0, 0, threads));
+		ptr[7] = 1;
+		EXPECT_EQ(7u, heap_verify(ptr, size, 0, 0, threads));
+
+		heap_fill_pattern(ptr, size, 0);
+		EXPECT_EQ(size, heap_verify(ptr, size, 0, 1, threads));
+		ptr[size / 2 + 9] ^= 1;
+		EXPECT_EQ(size / 2 + 9, heap_verify(ptr, size, 0, 1, threads));
+		EXPECT_EQ(size / 2 - 4096 + 9, heap_verify(ptr + 4096, size - 4096, 4096 / 8, 1, threads));
+	}
+
+	/* and through the default thread count */
+	EXPECT_EQ(size / 2 + 9, heap_verify_pattern(ptr, size, 0));
+
+	ASSERT_EQ(0, munmap(ptr, size));
+}